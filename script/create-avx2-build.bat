@@ -0,0 +1,2 @@
+pushd .. & mkdir build & pushd build & cmake -DVAJOLET_CPU_TYPE=64AVX2 -DCMAKE_BUILD_TYPE=Release -G "MinGW Makefiles" .. & mingw32-make
+
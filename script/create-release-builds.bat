@@ -14,3 +14,7 @@ CALL clean.bat
 CALL create-bmi2-build-clang.bat
 copy ..\build\src\Vajolet.exe ..\release\Vajolet2_2.9_bmi.exe
 CALL clean.bat
+
+CALL create-avx2-build-clang.bat
+copy ..\build\src\Vajolet.exe ..\release\Vajolet2_2.9_avx2.exe
+CALL clean.bat
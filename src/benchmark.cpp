@@ -15,15 +15,23 @@
     along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
 */
 
+#include <chrono>
 #include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "vajo_io.h"
+#include "movegen.h"
+#include "perft.h"
+#include "perftTable.h"
 #include "position.h"
 #include "search.h"
 #include "searchResult.h"
 #include "searchLimits.h"
+#include "searchStatistics.h"
 #include "searchTimer.h"
 #include "transposition.h"
 #include "uciParameters.h"
@@ -64,16 +72,20 @@ void benchmark() {
 	SearchLimits sl;
 	sl.setDepth(15);
 	Search src(st, sl, UciOutput::create(UciOutput::type::mute));
+	searchStatistics::threadScope statisticsScope;
+	searchStatistics::reset();
 	
 	
 	// iterate positions
 	uint64_t nodeCount = 0;
+	int64_t startLatency = 0;
 	unsigned int i = 0;
 	for (auto pos: positions) {	
 		src.getPosition().setupFromFen(pos);
 		sync_cout << "Position: " << (++i) << '/' << positions.size() << sync_endl;
 		src.manageNewSearch();
 		nodeCount += src.getVisitedNodes();
+		startLatency += src.getStartLatency();
 	}
 	
 	// get total time
@@ -84,5 +96,209 @@ void benchmark() {
 		<< "\nTotal time (ms) : " << totalTime
 		<< "\nNodes searched  : " << nodeCount
 		<< "\nNodes/second    : " << getNodesPerSecond(nodeCount, totalTime)
+		<< "\nSearch start (us): " << startLatency / static_cast<int64_t>(positions.size())
+		<< sync_endl;
+	for (auto& line: searchStatistics::getReport()) {
+		sync_cout << line << sync_endl;
+	}
+}
+
+static const std::vector<std::string> perftPositions = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+};
+
+void perftBenchmark(const unsigned int depth) {
+	const bool useHashBackup = Perft::perftUseHash;
+	Perft::perftUseHash = true;
+
+	SearchTimer st;
+	Position pos;
+
+	uint64_t nodeCount = 0;
+	unsigned int i = 0;
+	for (auto fen: perftPositions) {
+		PerftTranspositionTable::getInstance().clear();
+		pos.setupFromFen(fen);
+		const uint64_t n = Perft(pos).perft(depth);
+		sync_cout << "Position: " << (++i) << '/' << perftPositions.size() << " perft " << depth << ": " << n << sync_endl;
+		nodeCount += n;
+	}
+
+	const auto totalTime = st.getElapsedTime();
+	Perft::perftUseHash = useHashBackup;
+
+	sync_cout << "\n==========================="
+		<< "\nTotal time (ms) : " << totalTime
+		<< "\nLeaf nodes      : " << nodeCount
+		<< "\nNodes/second    : " << getNodesPerSecond(nodeCount, totalTime)
+		<< sync_endl;
+}
+
+/*! \brief read the positions of an epd file, only the first four fields of each line are used
+*/
+static bool loadEpd(const std::string& path, std::vector<std::string>& fens)
+{
+	std::ifstream f(path);
+	if (!f) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(f, line)) {
+		std::istringstream ss(line);
+		std::string board, turn, castle, ep;
+		if (ss >> board >> turn >> castle >> ep) {
+			fens.push_back(board + " " + turn + " " + castle + " " + ep + " 0 1");
+		}
+	}
+	return true;
+}
+
+/*! \brief run calls evaluations looping over the whole set of positions, return the elapsed time in nanoseconds
+	consecutive evaluations are always of different positions, so the hash tables see the same mix of positions as in a search
+*/
+static int64_t timeEvaluations(const std::vector<std::unique_ptr<Position>>& positions, const uint64_t calls, int64_t& checksum)
+{
+	const auto start = std::chrono::steady_clock::now();
+	size_t n = 0;
+	for (uint64_t i = 0; i < calls; ++i) {
+		checksum += positions[n]->eval<false>();
+		if (++n == positions.size()) {
+			n = 0;
+		}
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void evalBenchmark(const std::string& epdFile, const uint64_t calls) {
+	std::vector<std::string> fens;
+	if (epdFile.empty()) {
+		fens = positions;
+	} else if (!loadEpd(epdFile, fens) || fens.empty()) {
+		sync_cout << "info string unable to read positions from " << epdFile << sync_endl;
+		return;
+	}
+
+	sync_cout << "Positions       : " << fens.size()
+		<< "\nEvaluations     : " << calls
+		<< sync_endl;
+
+	// every position is set up only once, the timed loop only evaluates them
+	std::vector<std::unique_ptr<Position>> evalPositions;
+	for (auto& fen: fens) {
+		evalPositions.push_back(std::make_unique<Position>(Position::pawnHash::off));
+		evalPositions.back()->setupFromFen(fen);
+	}
+
+	searchStatistics::threadScope statisticsScope;
+	for (auto usePawnHash: { Position::pawnHash::on, Position::pawnHash::off }) {
+		// all the positions use the tables of the same evaluator, like a search thread does
+		const Position tablesOwner(usePawnHash);
+		for (auto& p: evalPositions) {
+			p->shareHashTables(tablesOwner);
+		}
+		int64_t checksum = 0;
+		searchStatistics::reset();
+		const int64_t evalTime = timeEvaluations(evalPositions, calls, checksum);
+
+		sync_cout << "\npawn hash " << (usePawnHash == Position::pawnHash::on ? "on" : "off")
+			<< "\nTotal time (ms) : " << evalTime / 1000000
+			<< "\nns/eval         : " << (calls ? evalTime / (int64_t)calls : 0)
+			<< "\nchecksum        : " << checksum
+			<< sync_endl;
+		for (auto& line: searchStatistics::getReport()) {
+			if (line.compare(0, 9, "pawn hash") == 0 || line.compare(0, 13, "material hash") == 0) {
+				sync_cout << line << sync_endl;
+			}
+		}
+	}
+}
+
+/*! \brief time rook plus bishop lookups from every square over the occupancies of the bench positions
+*/
+template<bitMap (*rookAttack)(const tSquare, const bitMap&), bitMap (*bishopAttack)(const tSquare, const bitMap&)>
+static int64_t timeAttacks(const std::vector<bitMap>& occupancies, const unsigned int iterations, bitMap& checksum)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < iterations; ++i) {
+		for (auto occupancy: occupancies) {
+			for (tSquare sq = A1; sq < squareNumber; ++sq) {
+				checksum += rookAttack(sq, occupancy) ^ bishopAttack(sq, occupancy);
+			}
+		}
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void attackBenchmark(const unsigned int iterations) {
+	std::vector<bitMap> occupancies;
+	Position pos(Position::pawnHash::off);
+	for (auto& fen: positions) {
+		pos.setupFromFen(fen);
+		occupancies.push_back(pos.getOccupationBitmap());
+	}
+	const uint64_t lookups = (uint64_t)iterations * occupancies.size() * 64;
+
+	auto report = [lookups](const std::string& name, const int64_t time, const bitMap checksum) {
+		sync_cout << "\n" << name
+			<< "\nTotal time (ms) : " << time / 1000000
+			<< "\nns/lookup       : " << (lookups ? (double)time / lookups : 0)
+			<< "\nchecksum        : " << checksum
+			<< sync_endl;
+	};
+
+	sync_cout << "Lookups         : " << lookups << sync_endl;
+
+	bitMap magicChecksum = 0;
+	const int64_t magicTime = timeAttacks<Movegen::magicAttackFromRook, Movegen::magicAttackFromBishop>(occupancies, iterations, magicChecksum);
+	report("magic", magicTime, magicChecksum);
+#ifdef __BMI2__
+	bitMap pextChecksum = 0;
+	const int64_t pextTime = timeAttacks<Movegen::pextAttackFromRook, Movegen::pextAttackFromBishop>(occupancies, iterations, pextChecksum);
+	report("pext", pextTime, pextChecksum);
+	if (pextChecksum != magicChecksum) {
+		sync_cout << "info string pext and magic attacks differ" << sync_endl;
+	}
+#else
+	sync_cout << "\npext not available, build with VAJOLET_CPU_TYPE 64BMI2 or 64AVX2" << sync_endl;
+#endif
+}
+
+/*! \brief time doMove plus undoMove of all the legal moves of the perft positions
+*/
+void doMoveBenchmark(const unsigned int iterations) {
+	std::vector<std::unique_ptr<Position>> parsed;
+	std::vector<MoveList<MAX_MOVE_PER_POSITION>> moves(perftPositions.size());
+	uint64_t movesPerIteration = 0;
+	for (unsigned int i = 0; i < perftPositions.size(); ++i) {
+		parsed.emplace_back(std::make_unique<Position>(Position::pawnHash::off));
+		parsed.back()->setupFromFen(perftPositions[i]);
+		parsed.back()->getMoveGen().generateMoves<Movegen::genType::allMg>(moves[i]);
+		movesPerIteration += moves[i].size();
+	}
+
+	uint64_t checksum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int n = 0; n < iterations; ++n) {
+		for (unsigned int i = 0; i < parsed.size(); ++i) {
+			Position& pos = *parsed[i];
+			for (auto& m: moves[i]) {
+				pos.doMove(m);
+				checksum += pos.getActualState().getKey().getKey();
+				pos.undoMove();
+			}
+		}
+	}
+	const int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	const uint64_t calls = movesPerIteration * iterations;
+
+	sync_cout << "state size      : " << sizeof(state)
+		<< "\nMoves           : " << calls
+		<< "\nTotal time (ms) : " << time / 1000000
+		<< "\nns/move         : " << (calls ? (double)time / calls : 0)
+		<< "\nchecksum        : " << checksum
 		<< sync_endl;
 }
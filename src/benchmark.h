@@ -17,8 +17,15 @@
 #ifndef BENCHMARK_H_
 #define BENCHMARK_H_
 
+#include <cstdint>
+#include <string>
+
 
 void benchmark();
+void perftBenchmark(const unsigned int depth);
+void evalBenchmark(const std::string& epdFile, const uint64_t calls);
+void attackBenchmark(const unsigned int iterations);
+void doMoveBenchmark(const unsigned int iterations);
 
 
 #endif /* BENCHMARK_H_ */
@@ -19,17 +19,22 @@
 //	include
 //---------------------------------------------
 #include <algorithm>
+#include <cctype>
 #include <iomanip>
 
 #include "benchmark.h"
 #include "command.h"
 #include "vajo_io.h"
 #include "movepicker.h"
+#include "nnue.h"
 #include "parameters.h"
 #include "perft.h"
+#include "pawnTable.h"
+#include "perftTable.h"
 #include "position.h"
 #include "pvLine.h"
 #include "rootMove.h"
+#include "searchStatistics.h"
 #include "searchTimer.h"
 #include "searchLimits.h"
 #include "syzygy/syzygy.h"
@@ -93,8 +98,46 @@ private:
 	{
 		unsigned long elements = transpositionTable::getInstance().setSize(size);
 		sync_cout<<"info string hash table allocated, "<<elements<<" elements ("<<size<<"MB)"<<sync_endl;
+		printTTMemoryType();
+	}
+	static void setLargePages(bool enable)
+	{
+		if( transpositionTable::getInstance().setLargePages(enable) )
+		{
+			printTTMemoryType();
+		}
+	}
+	static void printTTMemoryType()
+	{
+		sync_cout<<"info string hash table backed by "<<transpositionTable::getMemoryTypeName(transpositionTable::getInstance().getMemoryType())<<sync_endl;
 	}
 	static void clearHash() {transpositionTable::getInstance().clear();}
+	static void setPawnTableSize(unsigned int size)
+	{
+		unsigned long elements = pawnTable::setSize(size);
+		sync_cout<<"info string pawn hash table size "<<elements<<" elements per thread"<<sync_endl;
+	}
+	static void setPerftTTSize(unsigned int size)
+	{
+		unsigned long elements = PerftTranspositionTable::getInstance().setSize(size);
+		sync_cout<<"info string perft hash table allocated, "<<elements<<" elements ("<<size<<"MB)"<<sync_endl;
+	}
+	static void setEvalFile( std::string s ) {
+		auto& nnue = Nnue::getInstance();
+		if( s == "<empty>" || s.empty() )
+		{
+			nnue.unload();
+		}
+		else if( nnue.loadFromFile(s) )
+		{
+			sync_cout<<"info string nnue evaluation enabled, net loaded from "<<s<<sync_endl;
+		}
+		else
+		{
+			nnue.unload();
+			sync_cout<<"info string unable to load the net "<<s<<", using the classical evaluation"<<sync_endl;
+		}
+	}
 	static void setTTPath( std::string s ) {
 		auto&  szg = Syzygy::getInstance();
 		szg.setPath(s);
@@ -102,6 +145,8 @@ private:
 	}
 	std::string unusedVersion;
 	unsigned int unusedSize;
+	unsigned int unusedPerftSize;
+	unsigned int unusedPawnSize;
 	static const char _PIECE_NAMES_FEN[];
 	static const std::string _StartFEN;
 	
@@ -214,7 +259,7 @@ private:
 	class CheckUciOption final: public UciOption
 	{
 	public:
-		CheckUciOption( const std::string& name, bool& value, const bool defVal):UciOption(name),_defaultValue(defVal), _value(value)
+		CheckUciOption( const std::string& name, bool& value, const bool defVal, void (*callbackFunc)(bool) = nullptr):UciOption(name),_defaultValue(defVal), _value(value), _callbackFunc(callbackFunc)
 		{
 			setValue( _defaultValue ? "true" : "false", false );
 		}
@@ -249,11 +294,16 @@ private:
 				sync_cout<<"info string error setting "<<_name<<sync_endl;
 				return false;
 			}
+			if( _callbackFunc )
+			{
+				_callbackFunc(_value);
+			}
 			return true;
 		}
 	private:
 		const bool _defaultValue;
 		bool& _value;
+		void (*_callbackFunc)(bool);
 	};
 
 	class ButtonUciOption final: public UciOption
@@ -278,7 +328,9 @@ private:
 	void _printUciInfo(void);
 	Move _moveFromUci(const Position& pos,const  std::string& str);
 	void _position(std::istringstream& is);
-	void _doPerft(const unsigned int n);
+	void _doPerft(const unsigned int n, const unsigned int threads);
+	unsigned int _readPerftThreads(std::istringstream& is);
+	unsigned long long _readCount(std::istringstream& is, const unsigned long long defaultCount);
 	void _go(std::istringstream& is);
 	void _setoption(std::istringstream& is);
 	
@@ -293,7 +345,10 @@ UciManager::impl::impl(): _pos(Position::pawnHash::off)
 	std::cout.rdbuf()->pubsetbuf( nullptr, 0 );
 	std::cin.rdbuf()->pubsetbuf( nullptr, 0 );
 	
+	// LargePages is set before Hash to allocate the table only once at startup
+	_optionList.emplace_back( new CheckUciOption("LargePages", uciParameters::largePages, true, setLargePages));
 	_optionList.emplace_back( new SpinUciOption("Hash",unusedSize, setTTSize, 1, 1, 65535));
+	_optionList.emplace_back( new SpinUciOption("PawnHash", unusedPawnSize, setPawnTableSize, 1, 1, 1024));
 	_optionList.emplace_back( new SpinUciOption("Threads", uciParameters::threads, nullptr, 1, 1, 128));
 	_optionList.emplace_back( new SpinUciOption("MultiPV", uciParameters::multiPVLines, nullptr, 1, 1, 500));
 	_optionList.emplace_back( new CheckUciOption("Ponder", uciParameters::Ponder, true));
@@ -302,10 +357,13 @@ UciManager::impl::impl(): _pos(Position::pawnHash::off)
 	_optionList.emplace_back( new StringUciOption("UCI_EngineAbout", unusedVersion, nullptr, _getProgramNameAndVersion() + " by Marco Belli (build date: " + __DATE__ + " " + __TIME__ + ")"));
 	_optionList.emplace_back( new CheckUciOption("UCI_ShowCurrLine", uciParameters::showCurrentLine, false));
 	_optionList.emplace_back( new StringUciOption("SyzygyPath", uciParameters::SyzygyPath, setTTPath, "<empty>"));
+	_optionList.emplace_back( new StringUciOption("EvalFile", uciParameters::evalFile, setEvalFile, "<empty>"));
+	_optionList.emplace_back( new CheckUciOption("LazyEval", uciParameters::lazyEval, false));
 	_optionList.emplace_back( new SpinUciOption("SyzygyProbeDepth", uciParameters::SyzygyProbeDepth, nullptr, 1, 1, 100));
 	_optionList.emplace_back( new CheckUciOption("Syzygy50MoveRule", uciParameters::Syzygy50MoveRule, true));
 	_optionList.emplace_back( new ButtonUciOption("ClearHash", clearHash));
 	_optionList.emplace_back( new CheckUciOption("PerftUseHash", Perft::perftUseHash, false));
+	_optionList.emplace_back( new SpinUciOption("PerftHash", unusedPerftSize, setPerftTTSize, 1, 1, 65535));
 	_optionList.emplace_back( new CheckUciOption("reduceVerbosity", UciStandardOutput::reduceVerbosity, false));
 	_optionList.emplace_back( new CheckUciOption("UCI_Chess960", uciParameters::Chess960, false));
 	
@@ -582,6 +640,12 @@ void UciManager::impl::_position(std::istringstream& is)
 	// Parse move list (if any)
 	while( is >> token && (m = _moveFromUci(_pos, token) ) )
 	{
+		// the state stack of the position has room for MAX_GAME_PLY game plies plus the search
+		if( _pos.getStateSize() >= MAX_GAME_PLY )
+		{
+			sync_cout << "info string game longer than " << MAX_GAME_PLY << " plies, the remaining moves are ignored" << sync_endl;
+			break;
+		}
 		_pos.doMove(m);
 	}
 }
@@ -591,11 +655,11 @@ void UciManager::impl::_position(std::istringstream& is)
 	\version 1.0
 	\date 08/11/2013
 */
-void UciManager::impl::_doPerft(const unsigned int n)
+void UciManager::impl::_doPerft(const unsigned int n, const unsigned int threads)
 {
 	SearchTimer st;
 	
-	unsigned long long res = Perft(_pos).perft(n);
+	unsigned long long res = threads > 1 ? Perft(_pos).perft(n, threads) : Perft(_pos).perft(n);
 
 	long long int totalTime = std::max( st.getElapsedTime(), static_cast<int64_t>(1)) ;
 
@@ -603,6 +667,45 @@ void UciManager::impl::_doPerft(const unsigned int n)
 	sync_cout << totalTime << "ms " << ((double)res) / (double)totalTime << " kN/s" << sync_endl;
 }
 
+/*	\brief read the optional "threads <n>" parameter of perft and divide
+*/
+unsigned int UciManager::impl::_readPerftThreads(std::istringstream& is)
+{
+	std::string token;
+	int threads = 1;
+	if( is >> token && token == "threads" && is >> token )
+	{
+		try
+		{
+			threads = std::stoi(token);
+		}
+		catch(...)
+		{
+			threads = 1;
+		}
+	}
+	return std::max(threads, 1);
+}
+
+/*	\brief read the optional count parameter of the benchmarks, defaultCount is returned when it's missing or not valid
+*/
+unsigned long long UciManager::impl::_readCount(std::istringstream& is, const unsigned long long defaultCount)
+{
+	std::string token;
+	if( is >> token )
+	{
+		try
+		{
+			const long long n = std::stoll(token);
+			return n > 0 ? n : defaultCount;
+		}
+		catch(...)
+		{
+		}
+	}
+	return defaultCount;
+}
+
 void UciManager::impl::_go(std::istringstream& is)
 {
 	SearchLimits limits;
@@ -725,6 +828,12 @@ bool UciManager::impl::uciParser(std::string& cmd) {
 		Score s = _pos.eval<true>();
 		sync_cout << "Eval:" <<  s / 10000.0 << sync_endl;
 		sync_cout << "gamePhase:"  << _pos.getGamePhase( _pos.getActualState() )/65536.0*100 << "%" << sync_endl;
+		if( Nnue::getInstance().isLoaded() )
+		{
+			// a copy of the position uses the net loaded after the setup of _pos
+			const Position p( _pos, Position::pawnHash::off );
+			sync_cout << "NNUE eval:" << p.getStaticEval() / 10000.0 << sync_endl;
+		}
 
 	}
 	else if (token == "isready")
@@ -743,7 +852,7 @@ bool UciManager::impl::uciParser(std::string& cmd) {
 			n = 1;
 		}
 		n = std::max(n,1);
-		_doPerft(n);
+		_doPerft(n, _readPerftThreads(is));
 	}
 	else if (token == "divide" && (is>>token))
 	{
@@ -757,16 +866,96 @@ bool UciManager::impl::uciParser(std::string& cmd) {
 			n = 1;
 		}
 		
-		unsigned long long res = Perft(_pos).divide(n);
+		n = std::max(n,1);
+		unsigned long long res = Perft(_pos).divide(n, _readPerftThreads(is));
 		sync_cout << "divide Res= " << res << sync_endl;
 	}
 	else if (token == "go")
 	{
 		_go(is);
 	}
+	else if (token == "ttstats")
+	{
+		if( is >> token && token == "reset" )
+		{
+			searchStatistics::reset();
+		}
+		else
+		{
+			for( auto& line: searchStatistics::getReport() )
+			{
+				sync_cout << "info string " << line << sync_endl;
+			}
+		}
+	}
+	else if (token == "savehash")
+	{
+		std::string path;
+		std::getline( is >> std::ws, path );
+		if( !path.empty() && transpositionTable::getInstance().saveToFile(path) )
+		{
+			sync_cout << "info string hash table saved to " << path << sync_endl;
+		}
+		else
+		{
+			sync_cout << "info string error saving hash table to " << path << sync_endl;
+		}
+	}
+	else if (token == "loadhash")
+	{
+		std::string path;
+		std::getline( is >> std::ws, path );
+		auto& tt = transpositionTable::getInstance();
+		if( !path.empty() && tt.loadFromFile(path) )
+		{
+			sync_cout << "info string hash table loaded from " << path << ", " << tt.getElements() << " elements" << sync_endl;
+			printTTMemoryType();
+		}
+		else
+		{
+			sync_cout << "info string error loading hash table from " << path << sync_endl;
+		}
+	}
 	else if (token == "bench")
 	{
-		benchmark();
+		if( is >> token && token == "perft" )
+		{
+			perftBenchmark( std::max( (unsigned int)_readCount(is, 5), 2u ) );
+		}
+		else if( token == "attacks" )
+		{
+			// bench attacks [iterations], sliding attack lookups of the magic and pext backends
+			attackBenchmark( (unsigned int)_readCount(is, 100000) );
+		}
+		else if( token == "domove" )
+		{
+			// bench domove [iterations], doMove plus undoMove of the legal moves of the perft positions
+			doMoveBenchmark( (unsigned int)_readCount(is, 100000) );
+		}
+		else
+		{
+			benchmark();
+		}
+	}
+	else if (token == "evalbench")
+	{
+		// evalbench [epd file] [number of evaluations], a number alone is the number of evaluations of the bench positions
+		std::string path;
+		uint64_t calls = 1000000;
+		if( is >> token )
+		{
+			if( std::all_of( token.begin(), token.end(), [](const unsigned char c){ return std::isdigit(c); } ) )
+			{
+				std::istringstream count(token);
+				calls = _readCount( count, calls );
+			}
+			else
+			{
+				path = token;
+				calls = _readCount( is, calls );
+			}
+		}
+		evalBenchmark( path, calls );
 	}
 	else if (token == "ponderhit")
 	{
@@ -23,7 +23,7 @@
 //---------------------------------------------
 //	MATERIAL KEYS
 //---------------------------------------------
-std::unordered_map<tKey, Position::materialStruct> Position::_materialKeyMap;
+std::unordered_map<tKey, materialStruct> Position::_materialKeyMap;
 
 /**********************************************
 eval king and pieces vs lone king
@@ -18,6 +18,7 @@
 #include <iomanip>
 
 #include "vajo_io.h"
+#include "evalTable.h"
 #include "parameters.h"
 #include "pawnTable.h"
 #include "position.h"
@@ -40,21 +41,68 @@ simdScore traceRes={0,0,0,0};
 
 
 //---------------------------------------------
-const Position::materialStruct * Position::getMaterialData() const
+void Position::calcMaterialData(materialEntry& e) const
 {
-	tKey key = getMaterialKey().getKey();
+	const state &st = getActualState();
 
-	auto got= _materialKeyMap.find(key);
+	e.key = getMaterialKey().getKey();
 
-	if( got == _materialKeyMap.end())
+	auto got= _materialKeyMap.find(e.key);
+	e.hasEndgame = got != _materialKeyMap.end();
+	if( e.hasEndgame )
 	{
-		return nullptr;
+		e.endgame = got->second;
 	}
-	else
+	e.lonelyKing = (getPieceCount(whitePieces) == 1 && getPieceCount(blackPieces) > 1) || (getPieceCount(whitePieces) > 1 && getPieceCount(blackPieces) == 1);
+
+	e.kingRingNeeded[white] = st.getNonPawnValue()[ 2 ] >= Position::pieceValue[Knights][0] + Position::pieceValue[Rooks][0];
+	e.kingRingNeeded[black] = st.getNonPawnValue()[ 0 ] >= Position::pieceValue[Knights][0] + Position::pieceValue[Rooks][0];
+
+	const unsigned int pawns = getPieceCount(whitePawns) + getPieceCount(blackPawns);
+	e.scale[0] = std::min(160 + 14 * pawns, 256u);
+	e.scale[1] = std::min(160 + 4 * pawns, 256u);
+
+	e.gamePhase = getGamePhase( st );
+
+	simdScore imbalance = {0, 0, 0, 0};
+	if( pawns == 0 )
+	{
+		if((int)getPieceCount(whiteQueens) - (int)getPieceCount(blackQueens) == 1
+				&& (int)getPieceCount(blackRooks) - (int)getPieceCount(whiteRooks) == 1
+				&& (int)getPieceCount(blackBishops) + (int)getPieceCount(blackKnights) - (int)getPieceCount(whiteBishops) - (int)getPieceCount(whiteKnights) == 2)
+		{
+			imbalance += queenVsRook2MinorsImbalance;
+
+		}
+		else if((int)getPieceCount(whiteQueens) - (int)getPieceCount(blackQueens) == -1
+				&& (int)getPieceCount(blackRooks) - (int)getPieceCount(whiteRooks) == -1
+				&& (int)getPieceCount(blackBishops) + (int)getPieceCount(blackKnights) - (int)getPieceCount(whiteBishops) -(int)getPieceCount(whiteKnights) == -2)
+		{
+			imbalance -= queenVsRook2MinorsImbalance;
+
+		}
+	}
+	e.imbalance[0] = imbalance[0];
+	e.imbalance[1] = imbalance[1];
+}
+
+/*! \brief return the material data of the position
+	positions without a material hash table fill the data on the local entry given by the caller
+*/
+const materialEntry& Position::getMaterialData(materialEntry& localEntry) const
+{
+	if( !_materialHashTable )
 	{
-		 return &(got->second);
+		calcMaterialData( localEntry );
+		return localEntry;
 	}
 
+	materialEntry* e;
+	if( !_materialHashTable->probe( getMaterialKey(), e ) )
+	{
+		calcMaterialData( *e );
+	}
+	return *e;
 }
 
 
@@ -594,8 +642,12 @@ template<Color c> simdScore Position::evalKingSafety(Score kingSafety, unsigned
 
 
 		// long distance check
-		bitMap rMap = Movegen::attackFrom<whiteRooks>( kingSquare, getOccupationBitmap() );
-		bitMap bMap = Movegen::attackFrom<whiteBishops>( kingSquare, getOccupationBitmap() );
+		// when the attacker is on move, doMove has already calculated the checking squares toward this king
+		const state& st = getActualState();
+		const bool attackerOnMove = c ? st.isWhiteTurn() : st.isBlackTurn();
+		const bitMap rMap = attackerOnMove ? st.getCheckingSquares( c ? whiteRooks : blackRooks ) : Movegen::attackFrom<whiteRooks>( kingSquare, getOccupationBitmap() );
+		const bitMap bMap = attackerOnMove ? st.getCheckingSquares( c ? whiteBishops : blackBishops ) : Movegen::attackFrom<whiteBishops>( kingSquare, getOccupationBitmap() );
+		const bitMap nMap = attackerOnMove ? st.getCheckingSquares( c ? whiteKnights : blackKnights ) : Movegen::attackFrom<whiteKnights>( kingSquare );
 
 		if(  (rMap | bMap) & AttackedSquaresBy[Queens] &  ~AttackingPieces & undefendedSquares2 )
 		{
@@ -609,7 +661,7 @@ template<Color c> simdScore Position::evalKingSafety(Score kingSafety, unsigned
 		{
 			attackUnits += kingSafetyPars2[2];
 		}
-		if( Movegen::attackFrom<whiteKnights>( kingSquare ) & ( AttackedSquaresBy[Knights] ) & ~AttackingPieces & undefendedSquares2 )
+		if( nMap & ( AttackedSquaresBy[Knights] ) & ~AttackingPieces & undefendedSquares2 )
 		{
 			attackUnits += kingSafetyPars2[3];
 		}
@@ -622,7 +674,7 @@ template<Color c> simdScore Position::evalKingSafety(Score kingSafety, unsigned
 }
 
 
-simdScore Position::calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, bitMap * const attackedSquares , bitMap * const weakSquares, bitMap * const holes) const {
+simdScore Position::calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, const bitMap * const holes) const {
 	simdScore pawnResult = simdScore{0,0,0,0};
 	bitMap pawns = getBitmap(whitePawns);
 
@@ -640,7 +692,13 @@ simdScore Position::calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, bitMa
 		pawnResult -= evalPawn<black>(sq, weakPawns, passedPawns);
 	}
 
+	pawnResult -= ( (int)bitCnt( holes[white] ) - (int)bitCnt( holes[black] ) ) * holesPenalty;
+	return pawnResult;
+}
 
+/*! \brief calc the bitmaps derived from the pawn structure, they are cheap enough to not be saved in the pawn hash
+*/
+void Position::calcPawnMaps(bitMap * const attackedSquares , bitMap * const weakSquares, bitMap * const holes) const {
 
 	bitMap temp = getBitmap(whitePawns);
 	bitMap pawnAttack = (temp & ~fileMask(H1) ) << 9;
@@ -681,8 +739,14 @@ simdScore Position::calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, bitMa
 	temp |= temp >> 32;
 
 	holes[black] = weakSquares[black] & temp;
-	pawnResult -= ( (int)bitCnt( holes[white] ) - (int)bitCnt( holes[black] ) ) * holesPenalty;
-	return pawnResult;
+}
+
+/*! \brief interpolate the middlegame and endgame scores, mulCoeff will multiplicate only endgame
+*/
+static inline Score interpolateScore(const simdScore& res, const signed int gamePhase, const Score mulCoeff)
+{
+	signed long long r = (((signed long long)res[0]) * (65536 - gamePhase)) + (((signed long long)res[1]) * gamePhase * mulCoeff / 256);
+	return (Score)( (r) / 65536 );
 }
 
 /*! \brief do a pretty simple evalutation
@@ -693,6 +757,17 @@ simdScore Position::calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, bitMa
 template<bool trace>
 Score Position::eval(void) const
 {
+	bool exact;
+	return eval<trace>(-SCORE_INFINITE, SCORE_INFINITE, exact);
+}
+
+/*! \brief evalutation bounded by the alpha beta window
+	when the score can't fall inside the window the expensive terms are skipped and exact is set to false
+*/
+template<bool trace>
+Score Position::eval(const Score alpha, const Score beta, bool& exact) const
+{
+	exact = true;
 
 	const state &st = getActualState();
 
@@ -716,10 +791,11 @@ Score Position::eval(void) const
 	unsigned int kingAttackersWeight[2] = {0};
 	unsigned int kingAdjacentZoneAttacksCount[2] = {0};
 
-	
-	
+	materialEntry localMaterialData;
+	const materialEntry& materialData = getMaterialData( localMaterialData );
+
 	kingRing[white] = 0;
-	if( st.getNonPawnValue()[ 2 ] >= Position::pieceValue[Knights][0] + Position::pieceValue[Rooks][0] )
+	if( materialData.kingRingNeeded[white] )
 	{
 		tSquare k = getSquareOfThePiece(whiteKing);
 		if( getRankOf(k) == RANK1 )
@@ -738,7 +814,7 @@ Score Position::eval(void) const
 	}
 
 	kingRing[black] = 0;
-	if( st.getNonPawnValue()[ 0 ] >= Position::pieceValue[Knights][0] + Position::pieceValue[Rooks][0] )
+	if( materialData.kingRingNeeded[black] )
 	{
 		tSquare k = getSquareOfThePiece(blackKing);
 		if( getRankOf(k) == RANK8 )
@@ -768,14 +844,14 @@ Score Position::eval(void) const
 	//-----------------------------------------------------
 
 
-	const materialStruct* const materialData = getMaterialData();
-	if( materialData )
+	if( materialData.hasEndgame )
 	{
-		bool (Position::*pointer)(Score &) const = materialData->pointer;
-		switch(materialData->type)
+		const materialStruct& endgame = materialData.endgame;
+		bool (Position::*pointer)(Score &) const = endgame.pointer;
+		switch(endgame.type)
 		{
 			case materialStruct::type::exact:
-				return isBlackTurn() ? -materialData->val : materialData->val;
+				return isBlackTurn() ? -endgame.val : endgame.val;
 				break;
 			case materialStruct::type::multiplicativeFunction:
 			{
@@ -796,22 +872,19 @@ Score Position::eval(void) const
 				break;
 			}
 			case materialStruct::type::saturationH:
-				highSat = materialData->val;
+				highSat = endgame.val;
 				break;
 			case materialStruct::type::saturationL:
-				lowSat = materialData->val;
+				lowSat = endgame.val;
 				break;
 		}
 	}
-	else
+	else if( materialData.lonelyKing )
 	{
 		// analize k and pieces vs king
-		if( (bitCnt(getBitmap(whitePieces) )== 1 && bitCnt(getBitmap(blackPieces) )> 1) || (bitCnt(getBitmap(whitePieces) )> 1 && bitCnt(getBitmap(blackPieces) )== 1) )
-		{
-			Score r;
-			evalKxvsK(r);
-			return isBlackTurn() ? -r : r;
-		}
+		Score r;
+		evalKxvsK(r);
+		return isBlackTurn() ? -r : r;
 	}
 
 
@@ -849,23 +922,7 @@ Score Position::eval(void) const
 			res -= bishopPair;
 		}
 	}
-	if( getPieceCount(blackPawns) + getPieceCount(whitePawns) == 0 )
-	{
-		if((int)getPieceCount(whiteQueens) - (int)getPieceCount(blackQueens) == 1
-				&& (int)getPieceCount(blackRooks) - (int)getPieceCount(whiteRooks) == 1
-				&& (int)getPieceCount(blackBishops) + (int)getPieceCount(blackKnights) - (int)getPieceCount(whiteBishops) - (int)getPieceCount(whiteKnights) == 2)
-		{
-			res += queenVsRook2MinorsImbalance;
-
-		}
-		else if((int)getPieceCount(whiteQueens) - (int)getPieceCount(blackQueens) == -1
-				&& (int)getPieceCount(blackRooks) - (int)getPieceCount(whiteRooks) == -1
-				&& (int)getPieceCount(blackBishops) + (int)getPieceCount(blackKnights) - (int)getPieceCount(whiteBishops) -(int)getPieceCount(whiteKnights) == -2)
-		{
-			res -= queenVsRook2MinorsImbalance;
-
-		}
-	}
+	res += simdScore{ materialData.imbalance[0], materialData.imbalance[1], 0, 0 };
 
 	if(trace)
 	{
@@ -875,6 +932,38 @@ Score Position::eval(void) const
 		traceRes = res;
 	}
 
+	//---------------------------------------------
+	//	lazy eval
+	//---------------------------------------------
+	// the endgame scale is known in advance unless one of the late scalings below can apply
+	if( trace || alpha > -SCORE_INFINITE || beta < SCORE_INFINITE )
+	{
+		const simdScore& npv = st.getNonPawnValue();
+		if( mulCoeff != 256 || ( npv[0] + npv[2] >= 40000 && getPieceCount(whitePawns) + getPieceCount(blackPawns) != 0 ) )
+		{
+			const Score lazyCoeff = mulCoeff != 256 ? mulCoeff : materialData.scale[ isOppositeBishops() ? 1 : 0 ];
+			Score lazyScore = interpolateScore( res, materialData.gamePhase, lazyCoeff );
+			lazyScore = std::max( lowSat, std::min( highSat, lazyScore ) );
+			lazyScore = isBlackTurn() ? -lazyScore : lazyScore;
+			const Score margin = lazyEvalMargin[ materialData.gamePhase >> 14 ];
+
+			if(trace)
+			{
+				sync_cout << std::setw(20) << "lazy eval" << " | score " << lazyScore/10000.0 << " margin " << margin/10000.0 << sync_endl;
+			}
+			else
+			{
+				searchStatistics::increment(searchStatistics::lazyEvalProbes);
+				if( lazyScore - margin >= beta || lazyScore + margin <= alpha )
+				{
+					searchStatistics::increment(searchStatistics::lazyEvalCutoffs);
+					exact = false;
+					return lazyScore;
+				}
+			}
+		}
+	}
+
 
 	//todo specialized endgame & scaling function
 	//todo material imbalance
@@ -887,19 +976,20 @@ Score Position::eval(void) const
 	//----------------------------------------------
 	//	PAWNS EVALUTATION
 	//----------------------------------------------
+	calcPawnMaps(attackedSquares, weakSquares, holes);
 	if(const HashKey& pawnKey = getPawnKey(); _pawnHashTable) {
 		
-		if (simdScore tableScore; _pawnHashTable->getValues(pawnKey, tableScore, weakPawns, passedPawns, attackedSquares, weakSquares, holes)) {
+		if (simdScore tableScore; _pawnHashTable->getValues(pawnKey, tableScore, weakPawns, passedPawns)) {
 			res += tableScore;
 		} else {
-			simdScore pawnResult = calcPawnValues(weakPawns, passedPawns, attackedSquares, weakSquares, holes);
+			simdScore pawnResult = calcPawnValues(weakPawns, passedPawns, holes);
 			
-			_pawnHashTable->insert(pawnKey, pawnResult, weakPawns, passedPawns, attackedSquares, weakSquares, holes);			
+			_pawnHashTable->insert(pawnKey, pawnResult, weakPawns, passedPawns);			
 			res += pawnResult;
 
 		}
 	} else {
-		res += calcPawnValues(weakPawns, passedPawns, attackedSquares, weakSquares, holes);
+		res += calcPawnValues(weakPawns, passedPawns, holes);
 	}
 	
 	//---------------------------------------------
@@ -1310,7 +1400,7 @@ Score Position::eval(void) const
 	}
 	
 	if (mulCoeff == 256) {
-		mulCoeff = std::min(160 + (isOppositeBishops() ? 4 : 14) * (getPieceCount(whitePawns)+ getPieceCount(blackPawns)), 256u);
+		mulCoeff = materialData.scale[ isOppositeBishops() ? 1 : 0 ];
 	}
 	
 	if (trace) {
@@ -1320,11 +1410,7 @@ Score Position::eval(void) const
 	//--------------------------------------
 	//	finalizing
 	//--------------------------------------
-	signed int gamePhase = getGamePhase( st );
-	// mulCoeff will multiplicate only endgame
-	signed long long r = (((signed long long)res[0]) * (65536 - gamePhase)) + (((signed long long)res[1]) * gamePhase * mulCoeff / 256);
-
-	Score score = (Score)( (r) / 65536 );
+	Score score = interpolateScore( res, materialData.gamePhase, mulCoeff );
 
 	// final value saturation
 	score = std::min(highSat,score);
@@ -1336,3 +1422,39 @@ Score Position::eval(void) const
 
 template Score Position::eval<false>(void) const;
 template Score Position::eval<true>(void) const;
+template Score Position::eval<false>(const Score alpha, const Score beta, bool& exact) const;
+
+/*! \brief static evaluation of the position, served by the eval cache when the position owns one
+*/
+Score Position::getStaticEval(void) const
+{
+	bool exact;
+	return getStaticEval(-SCORE_INFINITE, SCORE_INFINITE, exact);
+}
+
+/*! \brief static evaluation bounded by the alpha beta window, the nnue one when a net is loaded
+	a lazy result is only guaranteed to be on the same side of the window as the full evaluation,
+	exact is cleared in that case and the score shall only be compared with the window
+*/
+Score Position::getStaticEval(const Score alpha, const Score beta, bool& exact) const
+{
+	exact = true;
+	const Nnue& nnue = Nnue::getInstance();
+	if(_nnueId != nnue.getId())
+	{
+		// the net has been changed after the position setup, neither the cache nor the accumulators can be trusted
+		return eval<false>(alpha, beta, exact);
+	}
+
+	const HashKey& key = getKey();
+	if(Score cached; _evalHashTable && _evalHashTable->getValue(key, cached))
+	{
+		return cached;
+	}
+	const Score score = _nnueId ? nnue.evaluate(*this, _nnueStack, _stateInfo.size() - 1) : eval<false>(alpha, beta, exact);
+	if(_evalHashTable && exact)
+	{
+		_evalHashTable->insert(key, score);
+	}
+	return score;
+}
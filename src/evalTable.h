@@ -0,0 +1,82 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#ifndef EVAL_TABLE_H_
+#define EVAL_TABLE_H_
+
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "hashKey.h"
+#include "score.h"
+#include "searchStatistics.h"
+
+/*! \brief static evaluation cache entry
+*/
+class alignas(16) evalEntry
+{
+public:
+	uint64_t key;
+	Score eval;
+};
+
+static_assert(sizeof(evalEntry) == 16, "four evalEntry shall fit a cache line");
+
+/*! \brief per thread cache of the static evaluation, direct-mapped and keyed by the full position key
+	the evaluation depends only on the position and on the evaluation backend, the table is cleared only when the backend changes
+*/
+class evalTable
+{
+public:
+	explicit evalTable(): _table(_size, evalEntry()){}
+
+	void clear()
+	{
+		std::fill(_table.begin(), _table.end(), evalEntry());
+	}
+
+	void insert(const HashKey& key, const Score eval)
+	{
+		evalEntry& x = _probe(key);
+		x.key = key.getKey();
+		x.eval = eval;
+	}
+
+	bool getValue(const HashKey& key, Score& eval) const
+	{
+		const evalEntry& x = _probe(key);
+
+		searchStatistics::increment(searchStatistics::evalProbes);
+		if (x.key == key.getKey()) {
+			searchStatistics::increment(searchStatistics::evalHits);
+			eval = x.eval;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	static constexpr unsigned long int _size = 65536;
+	std::vector<evalEntry> _table;
+	const evalEntry& _probe(const HashKey& key) const { return _table[key.getKey() & ( _size - 1 )]; }
+	evalEntry& _probe(const HashKey& key) { return _table[key.getKey() & ( _size - 1 )]; }
+};
+
+#endif /* EVAL_TABLE_H_ */
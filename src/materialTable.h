@@ -0,0 +1,92 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#ifndef MATERIAL_TABLE_H_
+#define MATERIAL_TABLE_H_
+
+
+#include <cstdint>
+#include <vector>
+
+#include "hashKey.h"
+#include "score.h"
+#include "searchStatistics.h"
+
+class Position;
+
+/*! \brief special evaluation of a known material configuration
+*/
+struct materialStruct
+{
+	using tType = enum class type
+	{
+		exact,
+		multiplicativeFunction,
+		exactFunction,
+		saturationH,
+		saturationL,
+	};
+	bool (Position::*pointer)(Score &) const;
+	tType type;
+	Score val;
+
+};
+
+/*! \brief material hash entry
+	everything eval needs that depends only on the material of the position, on a single cache line
+*/
+class alignas(64) materialEntry
+{
+public:
+	uint64_t key;
+	materialStruct endgame;
+	bool hasEndgame;		// endgame contains a known endgame evaluation
+	bool lonelyKing;		// one side has only the king left, while the other has other pieces
+	bool kingRingNeeded[2];	// the opponent has enough pieces to make king safety worth evaluating
+	unsigned short scale[2];	// endgame multiplier when bishops are not / are of opposite colours
+	unsigned int gamePhase;
+	Score imbalance[2];
+};
+
+static_assert(sizeof(materialEntry) == 64, "materialEntry shall fit a cache line");
+
+class materialTable
+{
+public:
+	explicit materialTable(): _table(_size, materialEntry()){}
+
+	/*! \brief return the slot of the key and whether it already contains the key
+		on a miss the caller has to fill the returned entry
+	*/
+	bool probe(const HashKey& key, materialEntry*& entry)
+	{
+		entry = &_table[key.getKey() & ( _size - 1 )];
+		searchStatistics::increment(searchStatistics::materialProbes);
+		if (entry->key == key.getKey()) {
+			searchStatistics::increment(searchStatistics::materialHits);
+			return true;
+		}
+		return false;
+	}
+
+private:
+	static constexpr unsigned long int _size = 8192;
+	std::vector<materialEntry> _table;
+};
+
+#endif /* MATERIAL_TABLE_H_ */
@@ -26,6 +26,11 @@
 bitMap Movegen::_KNIGHT_MOVE[squareNumber];
 bitMap Movegen::_KING_MOVE[squareNumber];
 bitMap Movegen::_PAWN_ATTACK[2][squareNumber];
+#ifdef __BMI2__
+Movegen::pextSlider Movegen::_pextRook[squareNumber];
+Movegen::pextSlider Movegen::_pextBishop[squareNumber];
+uint16_t Movegen::_pextAttacks[_pextTableSize];
+#endif
 
 bool Movegen::_isValidCoordinate( const int tofile, const int torank )
 {
@@ -43,6 +48,9 @@ void Movegen::_setBit( bitMap& b, tFile file, tRank rank )
 void Movegen::initMovegenConstant(void){
 	
 	initmagicmoves();
+#ifdef __BMI2__
+	_initPextAttacks();
+#endif
 	
 	struct coord{ int x; int y;};
 	std::list<coord> pawnsAttack[2] ={{{-1,1},{1,1}},{{-1,-1},{1,-1}}};
@@ -80,26 +88,111 @@ void Movegen::initMovegenConstant(void){
 	}
 }
 
+#ifdef __BMI2__
+/*! \brief fill the pext tables from the magic ones, initmagicmoves has to be called before
+*/
+void Movegen::_initPextAttacks(void)
+{
+	unsigned int offset = 0;
+	auto initSlider = [&offset]( pextSlider& s, const tSquare sq, const bitMap mask, bitMap (*magicAttack)(const tSquare, const bitMap&) )
+	{
+		s.mask = mask;
+		s.attacks = magicAttack( sq, 0 );
+		s.offset = offset;
+		assert( bitCnt( s.attacks ) <= 16 );
+
+		// enumerate all the subsets of the mask
+		bitMap occupancy = 0;
+		do
+		{
+			_pextAttacks[ offset + _pext_u64( occupancy, mask ) ] = (uint16_t)_pext_u64( magicAttack( sq, occupancy ), s.attacks );
+			occupancy = ( occupancy - mask ) & mask;
+		}
+		while( occupancy );
+
+		offset += 1u << bitCnt( mask );
+		assert( offset <= _pextTableSize );
+	};
+
+	for ( tSquare sq = A1; sq < squareNumber; ++sq )
+	{
+		initSlider( _pextRook[sq], sq, magicmoves_r_mask[sq], magicAttackFromRook );
+		initSlider( _pextBishop[sq], sq, magicmoves_b_mask[sq], magicAttackFromBishop );
+	}
+	assert( offset == _pextTableSize );
+}
+#endif
+
 
 
 template<Movegen::genType type>
 void Movegen::generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
 {
+	// the side to move is resolved once, all the generation is specialized for it
+	if( _pos.isBlackTurn() )
+	{
+		_generateMoves<type, black>( ml );
+	}
+	else
+	{
+		_generateMoves<type, white>( ml );
+	}
+}
+
+template<>
+void Movegen::generateMoves<Movegen::genType::allMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
+{
+	if( _pos.isBlackTurn() )
+	{
+		_generateAllMoves<black>( ml );
+	}
+	else
+	{
+		_generateAllMoves<white>( ml );
+	}
+}
+
+template void Movegen::generateMoves<Movegen::genType::captureMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+template void Movegen::generateMoves<Movegen::genType::quietMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+template void Movegen::generateMoves<Movegen::genType::quietChecksMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+template void Movegen::generateMoves<Movegen::genType::captureEvasionMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+template void Movegen::generateMoves<Movegen::genType::quietEvasionMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+
+template<Color c>
+inline void Movegen::_generateAllMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
+{
+	if(_pos.isInCheck())
+	{
+		_generateMoves<Movegen::genType::captureEvasionMg, c>( ml );
+		_generateMoves<Movegen::genType::quietEvasionMg, c>( ml );
+	}
+	else
+	{
+		_generateMoves<Movegen::genType::captureMg, c>( ml );
+		_generateMoves<Movegen::genType::quietMg, c>( ml );
+	}
+}
+
+template<Movegen::genType type, Color c>
+inline void Movegen::_generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
+{
+	constexpr bitboardIndex ourKing = c == white ? whiteKing : blackKing;
+	constexpr bitboardIndex ourPieces = c == white ? whitePieces : blackPieces;
+	constexpr bitboardIndex ourPawns = c == white ? whitePawns : blackPawns;
+	constexpr bitboardIndex theirPieces = c == white ? blackPieces : whitePieces;
 
 	// initialize constants
 	const state &s =_pos.getActualState();
-	const bitMap& enemy = _pos.getTheirBitmap(Pieces);
-	const bitMap& occupiedSquares = _pos.getOccupationBitmap();
-	
-	Color color = s.isBlackTurn()? black : white;
+	const bitMap enemy = _pos.getBitmap(theirPieces);
+	const bitMap occupiedSquares = _pos.getOccupationBitmap();
 
 	//divide pawns
-	const bitMap& seventhRankMask = rankMask( color ? A2:A7);
+	const bitMap seventhRankMask = rankMask( c ? A2:A7);
 
-	bitMap promotionPawns =  _pos.getOurBitmap(Pawns) & seventhRankMask ;
-	bitMap nonPromotionPawns =  _pos.getOurBitmap(Pawns)^ promotionPawns;
+	bitMap promotionPawns =  _pos.getBitmap(ourPawns) & seventhRankMask ;
+	bitMap nonPromotionPawns =  _pos.getBitmap(ourPawns)^ promotionPawns;
 
-	const tSquare kingSquare = _pos.getSquareOfOurKing();
+	const tSquare kingSquare = _pos.getSquareOfThePiece(ourKing);
 	assert(kingSquare<squareNumber);
 	
 	
@@ -107,32 +200,21 @@ void Movegen::generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
 	// populate the target squares bitmaps
 	bitMap kingTarget;
 	bitMap target;
-	/*if constexpr (type==Movegen::genType::allEvasionMg)
+	if constexpr (type==Movegen::genType::captureEvasionMg)
 	{
 		assert(s.getCheckers());
-		target = ( s.getCheckers() | getSquaresBetween(kingSquare, firstOne( s.getCheckers() ) ) ) & ~_pos.getOurBitmap(Pieces);
-		kingTarget = ~_pos.getOurBitmap(Pieces);
-	}
-	else */if constexpr (type==Movegen::genType::captureEvasionMg)
-	{
-		assert(s.getCheckers());
-		target = ( s.getCheckers() ) & ~_pos.getOurBitmap(Pieces);
-		kingTarget = target | _pos.getTheirBitmap(Pieces);
+		target = ( s.getCheckers() ) & ~_pos.getBitmap(ourPieces);
+		kingTarget = target | enemy;
 	}
 	else if constexpr (type==Movegen::genType::quietEvasionMg)
 	{
 		assert( s.getCheckers() );
-		target = ( getSquaresBetween( kingSquare, firstOne( s.getCheckers() ) ) ) & ~_pos.getOurBitmap(Pieces);
+		target = ( getSquaresBetween( kingSquare, firstOne( s.getCheckers() ) ) ) & ~_pos.getBitmap(ourPieces);
 		kingTarget = ~occupiedSquares;
 	}
-	/*else if constexpr (type== Movegen::genType::allNonEvasionMg)
-	{
-		target= ~_pos.getOurBitmap(Pieces);
-		kingTarget= target;
-	}*/
 	else if constexpr (type== Movegen::genType::captureMg)
 	{
-		target = _pos.getTheirBitmap(Pieces);
+		target = enemy;
 		kingTarget = target;
 	}
 	else if constexpr (type== Movegen::genType::quietMg)
@@ -148,8 +230,8 @@ void Movegen::generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
 	{
 		assert(false);
 		assert(s.getCheckers());
-		target = ( s.getCheckers() | getSquaresBetween( kingSquare, firstOne( s.getCheckers() ) ) ) & ~_pos.getOurBitmap(Pieces);
-		kingTarget = ~_pos.getOurBitmap(Pieces);
+		target = ( s.getCheckers() | getSquaresBetween( kingSquare, firstOne( s.getCheckers() ) ) ) & ~_pos.getBitmap(ourPieces);
+		kingTarget = ~_pos.getBitmap(ourPieces);
 	}
 
 
@@ -158,33 +240,32 @@ void Movegen::generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
 	//------------------------------------------------------
 	// king
 	//------------------------------------------------------
-	bitboardIndex piece = s.getKingOfActivePlayer();
 	_generateKingMoves<type>( ml, kingSquare, occupiedSquares, kingTarget, enemy );
 	
 	// if the king is in check from 2 enemy, it can only run away, we should not search any other move
-	if((/*type == Movegen::genType::allEvasionMg || */type == Movegen::genType::captureEvasionMg || type == Movegen::genType::quietEvasionMg) && s.isInDoubleCheck() )
+	if((type == Movegen::genType::captureEvasionMg || type == Movegen::genType::quietEvasionMg) && s.isInDoubleCheck() )
 	{
 		return;
 	}
 	//------------------------------------------------------
 	// queen
 	//------------------------------------------------------
-	_generatePieceMoves<type>( ml, &_attackFromQueen, ++piece, kingSquare, occupiedSquares, target );
+	_generatePieceMoves<type>( ml, &_attackFromQueen, bitboardIndex( ourKing + 1 ), kingSquare, occupiedSquares, target );
 	
 	//------------------------------------------------------
 	// rook
 	//------------------------------------------------------
-	_generatePieceMoves<type>( ml, &_attackFromRook, ++piece, kingSquare, occupiedSquares, target );
+	_generatePieceMoves<type>( ml, &_attackFromRook, bitboardIndex( ourKing + 2 ), kingSquare, occupiedSquares, target );
 	
 	//------------------------------------------------------
 	// bishop
 	//------------------------------------------------------
-	_generatePieceMoves<type>( ml, &_attackFromBishop, ++piece, kingSquare, occupiedSquares, target );
+	_generatePieceMoves<type>( ml, &_attackFromBishop, bitboardIndex( ourKing + 3 ), kingSquare, occupiedSquares, target );
 
 	//------------------------------------------------------
 	// knight
 	//------------------------------------------------------
-	_generatePieceMoves<type>( ml, &_attackFromKnight, ++piece, kingSquare, occupiedSquares, target );
+	_generatePieceMoves<type>( ml, &_attackFromKnight, bitboardIndex( ourKing + 4 ), kingSquare, occupiedSquares, target );
 
 	
 	//------------------------------------------------------
@@ -193,53 +274,58 @@ void Movegen::generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
 	if constexpr ( type != Movegen::genType::captureMg && type != Movegen::genType::captureEvasionMg )
 	{
 		//push
-		bitMap pawnPushed = _generatePawnPushes<type,false>( ml, color, nonPromotionPawns, kingSquare, occupiedSquares, target );
+		bitMap pawnPushed = _generatePawnPushes<type, false, c>( ml, nonPromotionPawns, kingSquare, occupiedSquares, target );
 		//double push
-		_generatePawnDoublePushes<type>( ml, color, pawnPushed, kingSquare, occupiedSquares, target );
+		_generatePawnDoublePushes<type, c>( ml, pawnPushed, kingSquare, occupiedSquares, target );
 	}
 
 	if constexpr (type!= Movegen::genType::quietMg && type!=Movegen::genType::quietChecksMg && type != Movegen::genType::quietEvasionMg)
 	{
 		//left capture
-		_generatePawnCaptureLeft<type,false>( ml, color, nonPromotionPawns, kingSquare, target, enemy );
+		_generatePawnCaptureLeft<type, false, c>( ml, nonPromotionPawns, kingSquare, target, enemy );
 
 		//right capture
-		_generatePawnCaptureRight<type,false>( ml, color, nonPromotionPawns, kingSquare, target, enemy );
+		_generatePawnCaptureRight<type, false, c>( ml, nonPromotionPawns, kingSquare, target, enemy );
 
 	}
 	
 	// PROMOTIONS
-	if(type != Movegen::genType::captureMg && type != Movegen::genType::captureEvasionMg)
+	if constexpr (type != Movegen::genType::captureMg && type != Movegen::genType::captureEvasionMg)
 	{
 		//push
-		_generatePawnPushes<type,true>( ml, color, promotionPawns, kingSquare, occupiedSquares, target );
+		_generatePawnPushes<type, true, c>( ml, promotionPawns, kingSquare, occupiedSquares, target );
 	}
 
-	if( type!= Movegen::genType::quietMg && type!= Movegen::genType::quietChecksMg && type!= Movegen::genType::quietEvasionMg)
+	if constexpr ( type!= Movegen::genType::quietMg && type!= Movegen::genType::quietChecksMg && type!= Movegen::genType::quietEvasionMg)
 	{
 		//left capture
-		_generatePawnCaptureLeft<type,true>( ml, color, promotionPawns, kingSquare, target, enemy );
+		_generatePawnCaptureLeft<type, true, c>( ml, promotionPawns, kingSquare, target, enemy );
 
 		//right capture
-		_generatePawnCaptureRight<type,true>( ml, color, promotionPawns, kingSquare, target, enemy );
+		_generatePawnCaptureRight<type, true, c>( ml, promotionPawns, kingSquare, target, enemy );
 
 		// ep capture
-		_generateEpMove( ml, color, nonPromotionPawns, occupiedSquares, kingSquare );
+		_generateEpMove<c>( ml, nonPromotionPawns, occupiedSquares, kingSquare );
 	}
 
 	//king castle
-	if(/*type !=Movegen::genType::allEvasionMg && */type!=Movegen::genType::captureEvasionMg && type!=Movegen::genType::quietEvasionMg && type!= Movegen::genType::captureMg)
+	if constexpr (type!=Movegen::genType::captureEvasionMg && type!=Movegen::genType::quietEvasionMg && type!= Movegen::genType::captureMg)
 	{
-		if( !s.isInCheck() && s.hasCastleRight( castleOO | castleOOO, color ) )
+		if( !s.isInCheck() && s.hasCastleRight( castleOO | castleOOO, c ) )
 		{
-			_generateCastle<type>( ml, color, castleOO, kingSquare, occupiedSquares );
-			_generateCastle<type>( ml, color, castleOOO, kingSquare, occupiedSquares );
+			if( _pos.hasStandardCastling() )
+			{
+				_generateCastle<type, c, true>( ml, castleOO, kingSquare, occupiedSquares );
+				_generateCastle<type, c, true>( ml, castleOOO, kingSquare, occupiedSquares );
+			}
+			else
+			{
+				_generateCastle<type, c, false>( ml, castleOO, kingSquare, occupiedSquares );
+				_generateCastle<type, c, false>( ml, castleOOO, kingSquare, occupiedSquares );
+			}
 		}
 	}
 }
-template void Movegen::generateMoves<Movegen::genType::captureMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
-template void Movegen::generateMoves<Movegen::genType::quietMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
-template void Movegen::generateMoves<Movegen::genType::quietChecksMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
 
 template<Movegen::genType type>
 inline void Movegen::_insertStandardMove( MoveList<MAX_MOVE_PER_POSITION>& ml, const Move& m ) const
@@ -271,7 +357,7 @@ inline void Movegen::_generateKingMoves( MoveList<MAX_MOVE_PER_POSITION>& ml, co
 	while(moves)
 	{
 		tSquare to = iterateBit(moves);
-		if( !(_pos.getAttackersTo(to, occupiedSquares & ~_pos.getOurBitmap(King)) & enemy) )
+		if( !(_pos.getAttackersTo(to, occupiedSquares & ~bitSet(kingSquare)) & enemy) )
 		{
 			m.setTo( to );
 			_insertStandardMove<type>( ml, m );
@@ -305,12 +391,12 @@ inline void Movegen::_generatePieceMoves( MoveList<MAX_MOVE_PER_POSITION>& ml, b
 	}
 }
 
-template<Movegen::genType type, bool promotion>
-inline bitMap Movegen::_generatePawnPushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const
+template<Movegen::genType type, bool promotion, Color c>
+inline bitMap Movegen::_generatePawnPushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const
 {
 	bitMap pawnPushed;
 	//push
-	bitMap moves = ( color? (pawns>>8):(pawns<<8)) & ~occupiedSquares;
+	bitMap moves = ( c? (pawns>>8):(pawns<<8)) & ~occupiedSquares;
 	pawnPushed = moves;
 	moves &= target;
 	
@@ -323,7 +409,7 @@ inline bitMap Movegen::_generatePawnPushes( MoveList<MAX_MOVE_PER_POSITION>& ml,
 	while(moves)
 	{
 		tSquare to = iterateBit(moves);
-		tSquare from = to - pawnPush( color );
+		tSquare from = to - pawnPush( c );
 		
 		if( !_pos.getActualState().isPinned( from ) || squaresAligned(from,to,kingSquare))
 		{
@@ -342,17 +428,17 @@ inline bitMap Movegen::_generatePawnPushes( MoveList<MAX_MOVE_PER_POSITION>& ml,
 	return pawnPushed;
 }
 
-template<Movegen::genType type>
-inline void Movegen::_generatePawnDoublePushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const
+template<Movegen::genType type, Color c>
+inline void Movegen::_generatePawnDoublePushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const
 {
 	//double push
-	const bitMap& thirdRankMask = rankMask( color ? A6:A3);
-	bitMap moves = ( color? ((pawns & thirdRankMask)>>8):((pawns & thirdRankMask)<<8)) & ~occupiedSquares & target;
+	const bitMap thirdRankMask = rankMask( c ? A6:A3);
+	bitMap moves = ( c? ((pawns & thirdRankMask)>>8):((pawns & thirdRankMask)<<8)) & ~occupiedSquares & target;
 	Move m(Move::NOMOVE);
 	while(moves)
 	{
 		tSquare to = iterateBit(moves);
-		tSquare from = to - 2 * pawnPush( color );
+		tSquare from = to - 2 * pawnPush( c );
 
 		if( !_pos.getActualState().isPinned( from ) || squaresAligned(from ,to ,kingSquare))
 		{
@@ -362,21 +448,21 @@ inline void Movegen::_generatePawnDoublePushes( MoveList<MAX_MOVE_PER_POSITION>&
 		}
 	}
 }
-template<Movegen::genType type, bool promotion>
-inline void Movegen::_generatePawnCaptureLeft( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const
+template<Movegen::genType type, bool promotion, Color c>
+inline void Movegen::_generatePawnCaptureLeft( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const
 {
 	//left capture
-	int delta = color? -9: 7;
-	bitMap moves = ( color? (pawns&~fileMask(A1))>>9: (pawns&~fileMask(A1))<<7) & enemy & target;
+	constexpr int delta = c? -9: 7;
+	bitMap moves = ( c? (pawns&~fileMask(A1))>>9: (pawns&~fileMask(A1))<<7) & enemy & target;
 	_generatePawnCapture<type, promotion>( ml, delta, moves, kingSquare );
 }
 
-template<Movegen::genType type, bool promotion>
-inline void Movegen::_generatePawnCaptureRight( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const
+template<Movegen::genType type, bool promotion, Color c>
+inline void Movegen::_generatePawnCaptureRight( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const
 {
 	//right capture
-	int delta= color? -7: 9;
-	bitMap moves = ( color? (pawns&~fileMask(H1))>>7: (pawns&~fileMask(H1))<<9) & enemy & target;
+	constexpr int delta= c? -7: 9;
+	bitMap moves = ( c? (pawns&~fileMask(H1))>>7: (pawns&~fileMask(H1))<<9) & enemy & target;
 	_generatePawnCapture<type, promotion>( ml, delta, moves, kingSquare );
 }
 
@@ -410,14 +496,19 @@ inline void Movegen::_generatePawnCapture( MoveList<MAX_MOVE_PER_POSITION>& ml,
 	}
 }
 
-inline void Movegen::_generateEpMove(MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const bitMap occupiedSquares, const tSquare kingSquare) const
+template<Color c>
+inline void Movegen::_generateEpMove(MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const bitMap occupiedSquares, const tSquare kingSquare) const
 {
+	constexpr bitboardIndex theirQueens = c == white ? blackQueens : whiteQueens;
+	constexpr bitboardIndex theirRooks = c == white ? blackRooks : whiteRooks;
+	constexpr bitboardIndex theirBishops = c == white ? blackBishops : whiteBishops;
+
 	if( _pos.getActualState().hasEpSquare() )
 	{
 		auto epSquare = _pos.getActualState().getEpSquare();
 		Move m(Move::NOMOVE);
 		m.setFlag( Move::fenpassant );
-		bitMap epAttacker = pawns & _attackFromPawn( epSquare, 1 - color );
+		bitMap epAttacker = pawns & _attackFromPawn( epSquare, 1 - c );
 
 		while(epAttacker)
 		{
@@ -426,8 +517,8 @@ inline void Movegen::_generateEpMove(MoveList<MAX_MOVE_PER_POSITION>& ml, const
 			bitMap captureSquare= fileMask( epSquare ) & rankMask(from);
 			bitMap occ = occupiedSquares^bitSet(from)^bitSet( epSquare )^captureSquare;
 
-			if(	!((_attackFromRook(kingSquare, occ) & (_pos.getTheirBitmap(Queens) | _pos.getTheirBitmap(Rooks))) |
-				(_attackFromBishop(kingSquare, occ) & (_pos.getTheirBitmap(Queens) | _pos.getTheirBitmap(Bishops))))
+			if(	!((_attackFromRook(kingSquare, occ) & (_pos.getBitmap(theirQueens) | _pos.getBitmap(theirRooks))) |
+				(_attackFromBishop(kingSquare, occ) & (_pos.getBitmap(theirQueens) | _pos.getBitmap(theirBishops))))
 			)
 			{
 				m.setTo( epSquare );
@@ -439,35 +530,19 @@ inline void Movegen::_generateEpMove(MoveList<MAX_MOVE_PER_POSITION>& ml, const
 	}
 }
 
-template<>
-void Movegen::generateMoves<Movegen::genType::allMg>( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
-{
-
-	if(_pos.isInCheck())
-	{
-		generateMoves<Movegen::genType::captureEvasionMg>( ml);
-		generateMoves<Movegen::genType::quietEvasionMg>( ml );
-	}
-	else
-	{
-		generateMoves<Movegen::genType::captureMg>( ml );
-		generateMoves<Movegen::genType::quietMg>( ml );
-	}
-
-}
-
-template<Movegen::genType type>
-inline void Movegen::_generateCastle( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const eCastle castle,  const tSquare kingSquare, const bitMap occupiedSquares )const
+template<Movegen::genType type, Color c, bool standard>
+inline void Movegen::_generateCastle( MoveList<MAX_MOVE_PER_POSITION>& ml, const eCastle castle,  const tSquare kingSquare, const bitMap occupiedSquares )const
 {
-	eCastle cr = state::calcCastleRight( castle, color );
-	if( _pos.getActualState().hasCastleRight( cr ) && _pos.isCastlePathFree( cr ) )
+	constexpr bitboardIndex theirPieces = c == white ? blackPieces : whitePieces;
+	eCastle cr = state::calcCastleRight( castle, c );
+	if( _pos.getActualState().hasCastleRight( cr ) && _pos.isCastlePathFree<standard>( cr ) )
 	{
-		auto kp = _pos.getCastleKingPath(cr);
-		auto rookSq = _pos.getCastleRookInvolved(cr);
+		auto kp = _pos.getCastleKingPath<standard>(cr);
+		auto rookSq = _pos.getCastleRookInvolved<standard>(cr);
 		while(kp)
 		{
 			tSquare x = iterateBit(kp);
-			if(_pos.getTheirBitmap(Pieces) & _pos.getAttackersTo(x, occupiedSquares^ bitSet(rookSq) ))
+			if(_pos.getBitmap(theirPieces) & _pos.getAttackersTo(x, occupiedSquares^ bitSet(rookSq) ))
 			{
 				return;
 			}
@@ -19,6 +19,10 @@
 #ifndef MOVEGEN_H_
 #define MOVEGEN_H_
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 #include "bitops.h"
 #include "magicmoves.h"
 #include "moveList.h"
@@ -97,6 +101,38 @@ public:
 		return _attackFromBishop(from, 0);
 	}
 	
+	/*! \brief sliding attacks read from the magic tables, available in every build to compare them with the pext ones
+	*/
+	inline static bitMap magicAttackFromRook(const tSquare from, const bitMap& occupancy)
+	{
+		assert(from <squareNumber);
+		return *(magicmoves_r_indices[from]+(((occupancy&magicmoves_r_mask[from])*magicmoves_r_magics[from])>>magicmoves_r_shift[from]));
+	}
+
+	inline static bitMap magicAttackFromBishop(const tSquare from, const bitMap& occupancy)
+	{
+		assert(from <squareNumber);
+		return *(magicmoves_b_indices[from]+(((occupancy&magicmoves_b_mask[from])*magicmoves_b_magics[from])>>magicmoves_b_shift[from]));
+	}
+
+#ifdef __BMI2__
+	/*! \brief sliding attacks indexed by pext, the table entry is expanded with pdep over the attacks on the empty board
+	*/
+	inline static bitMap pextAttackFromRook(const tSquare from, const bitMap& occupancy)
+	{
+		assert(from <squareNumber);
+		const pextSlider& s = _pextRook[from];
+		return _pdep_u64( _pextAttacks[ s.offset + _pext_u64( occupancy, s.mask ) ], s.attacks );
+	}
+
+	inline static bitMap pextAttackFromBishop(const tSquare from, const bitMap& occupancy)
+	{
+		assert(from <squareNumber);
+		const pextSlider& s = _pextBishop[from];
+		return _pdep_u64( _pextAttacks[ s.offset + _pext_u64( occupancy, s.mask ) ], s.attacks );
+	}
+#endif
+
 	/* non static methods */
 	template<Movegen::genType type>	void generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml) const;
 
@@ -108,18 +144,40 @@ private:
 	static bitMap _KNIGHT_MOVE[squareNumber];
 	static bitMap _KING_MOVE[squareNumber];
 	static bitMap _PAWN_ATTACK[2][squareNumber];
+
+#ifdef __BMI2__
+	struct pextSlider
+	{
+		bitMap mask;			// occupancy squares changing the attacks, board edges excluded
+		bitMap attacks;			// attacks on the empty board
+		unsigned int offset;	// index of the first entry of the square in _pextAttacks
+	};
+	static pextSlider _pextRook[squareNumber];
+	static pextSlider _pextBishop[squareNumber];
+	// rook and bishop attacks of all the squares in a single table, every entry is compressed to 16 bits by pext over pextSlider::attacks
+	static constexpr unsigned int _pextTableSize = 102400 + 5248;
+	static uint16_t _pextAttacks[_pextTableSize];
+
+	static void _initPextAttacks(void);
+#endif
 	
 	/* static methods */
 	inline static bitMap _attackFromRook(const tSquare from, const bitMap& occupancy)
 	{
-		assert(from <squareNumber);
-		return *(magicmoves_r_indices[from]+(((occupancy&magicmoves_r_mask[from])*magicmoves_r_magics[from])>>magicmoves_r_shift[from]));
+#ifdef __BMI2__
+		return pextAttackFromRook(from, occupancy);
+#else
+		return magicAttackFromRook(from, occupancy);
+#endif
 	}
 
 	inline static bitMap _attackFromBishop(const tSquare from, const bitMap& occupancy)
 	{
-		assert(from <squareNumber);
-		return *(magicmoves_b_indices[from]+(((occupancy&magicmoves_b_mask[from])*magicmoves_b_magics[from])>>magicmoves_b_shift[from]));
+#ifdef __BMI2__
+		return pextAttackFromBishop(from, occupancy);
+#else
+		return magicAttackFromBishop(from, occupancy);
+#endif
 	}
 	
 	inline static bitMap _attackFromQueen(const tSquare from, const bitMap& occupancy)
@@ -156,23 +214,26 @@ private:
 	template<Movegen::genType type>	void _insertStandardMove( MoveList<MAX_MOVE_PER_POSITION>& ml, const Move& m ) const;
 	void _insertPromotionMoves( MoveList<MAX_MOVE_PER_POSITION>& ml, Move& m ) const;
 	
+	template<Movegen::genType type, Color c> void _generateMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+	template<Color c> void _generateAllMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
+	
 	template<Movegen::genType type>	void _generateKingMoves( MoveList<MAX_MOVE_PER_POSITION>& ml, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap kingTarget, const bitMap enemy )const;
 	
 	template<Movegen::genType type>	void _generatePieceMoves( MoveList<MAX_MOVE_PER_POSITION>& ml, bitMap (*attack)(const tSquare,const bitMap&),const bitboardIndex piece, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target)const;
 	
-	template<Movegen::genType type, bool promotion> bitMap _generatePawnPushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const;
+	template<Movegen::genType type, bool promotion, Color c> bitMap _generatePawnPushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const;
 	
-	template<Movegen::genType type> void _generatePawnDoublePushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const;
+	template<Movegen::genType type, Color c> void _generatePawnDoublePushes( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap occupiedSquares, const bitMap target )const;
 	
-	template<Movegen::genType type, bool promotion> void _generatePawnCaptureLeft( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const;
+	template<Movegen::genType type, bool promotion, Color c> void _generatePawnCaptureLeft( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const;
 	
-	template<Movegen::genType type, bool promotion> void _generatePawnCaptureRight( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const;
+	template<Movegen::genType type, bool promotion, Color c> void _generatePawnCaptureRight( MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const tSquare kingSquare, const bitMap target, const bitMap enemy )const;
 	
 	template<Movegen::genType type, bool promotion> void _generatePawnCapture( MoveList<MAX_MOVE_PER_POSITION>& ml, int delta, bitMap moves, const tSquare kingSquare)const;
 	
-	inline void _generateEpMove(MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const bitMap& pawns, const bitMap occupiedSquares, const tSquare kingSquare) const;
+	template<Color c> void _generateEpMove(MoveList<MAX_MOVE_PER_POSITION>& ml, const bitMap& pawns, const bitMap occupiedSquares, const tSquare kingSquare) const;
 	
-	template<Movegen::genType type>void _generateCastle( MoveList<MAX_MOVE_PER_POSITION>& ml, const Color color, const eCastle castle, const tSquare kingSquare, const bitMap occupiedSquares )const;
+	template<Movegen::genType type, Color c, bool standard> void _generateCastle( MoveList<MAX_MOVE_PER_POSITION>& ml, const eCastle castle, const tSquare kingSquare, const bitMap occupiedSquares )const;
 };
 
 
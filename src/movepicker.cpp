@@ -18,6 +18,7 @@
 #include "movepicker.h"
 #include "position.h"
 #include "searchData.h"
+#include "searchStatistics.h"
 // cppcheck-suppress uninitMemberVar symbolName=MovePicker::_killerPos
 // cppcheck-suppress uninitMemberVar symbolName=MovePicker::_captureThreshold
 MovePicker::MovePicker( const Position& p, const SearchData& sd, unsigned int ply, const Move& ttm ): _pos(p), _mg(p.getMoveGen()), _sd(sd), _ply(ply), _ttMove(ttm)
@@ -214,6 +215,12 @@ Move MovePicker::getNextMove()
 			{
 				return _ttMove;
 			}
+			if( _ttMove )
+			{
+				// the move saved in the transposition table isn't legal here: usually the move kept by store
+				// when the slot was overwritten by another position, rarely a key collision
+				searchStatistics::increment(searchStatistics::illegalTTMoves);
+			}
 			break;
 			
 		default:
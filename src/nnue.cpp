@@ -0,0 +1,296 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "bitops.h"
+#include "nnue.h"
+#include "position.h"
+
+const char Nnue::fileMagic[8] = { 'V', 'A', 'J', 'O', 'N', 'N', 'U', 'E' };
+
+struct Nnue::network
+{
+	alignas(32) int16_t featureBiases[halfDimensions];
+	alignas(32) int16_t featureWeights[inputDimensions][halfDimensions];
+	alignas(32) int32_t hidden1Biases[hiddenDimensions];
+	alignas(32) int8_t hidden1Weights[hiddenDimensions][2 * halfDimensions];
+	alignas(32) int32_t hidden2Biases[hiddenDimensions];
+	alignas(32) int8_t hidden2Weights[hiddenDimensions][hiddenDimensions];
+	int32_t outputBias;
+	alignas(32) int8_t outputWeights[hiddenDimensions];
+};
+
+struct nnueFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t halfDimensions;
+	uint32_t hiddenDimensions;
+};
+
+// the hidden layers outputs are shifted right by weightsShift before being clipped
+static constexpr int weightsShift = 6;
+
+Nnue::Nnue() = default;
+Nnue::~Nnue() = default;
+
+template<typename T>
+static bool readArray(std::ifstream& f, T& data)
+{
+	return (bool)f.read( reinterpret_cast<char*>(&data), sizeof(data) );
+}
+
+bool Nnue::loadFromFile(const std::string& path)
+{
+	std::ifstream f( path, std::ios::binary );
+	nnueFileHeader h;
+	if( !f || !readArray( f, h ) )
+	{
+		return false;
+	}
+	if( std::memcmp( h.magic, fileMagic, sizeof(h.magic) ) != 0 || h.version != fileVersion || h.halfDimensions != halfDimensions || h.hiddenDimensions != hiddenDimensions )
+	{
+		return false;
+	}
+
+	auto net = std::make_unique<network>();
+	if( !readArray( f, net->featureBiases )
+		|| !readArray( f, net->featureWeights )
+		|| !readArray( f, net->hidden1Biases )
+		|| !readArray( f, net->hidden1Weights )
+		|| !readArray( f, net->hidden2Biases )
+		|| !readArray( f, net->hidden2Weights )
+		|| !readArray( f, net->outputBias )
+		|| !readArray( f, net->outputWeights )
+		|| f.peek() != std::ifstream::traits_type::eof() )
+	{
+		return false;
+	}
+
+	_net = std::move(net);
+	_id = ++_loadCount;
+	return true;
+}
+
+void Nnue::unload()
+{
+	_net.reset();
+	_id = 0;
+}
+
+unsigned int Nnue::getFeatureIndex(const Color perspective, const tSquare kingSquare, const bitboardIndex piece, const tSquare sq)
+{
+	assert( isValidPiece( piece ) && !isKing( piece ) );
+	// black sees the board upside down, with its pieces as the friendly ones
+	const unsigned int flip = perspective == white ? 0 : 56;
+	const unsigned int kind = ( getPieceType( piece ) - Queens ) + ( isBlackPiece( piece ) == ( perspective == black ) ? 0 : 5 );
+	return ( ( ( kingSquare ^ flip ) * 10 + kind ) * 64 ) + ( sq ^ flip );
+}
+
+static inline void addRow(int16_t* const acc, const int16_t* const row)
+{
+#ifdef __AVX2__
+	for( unsigned int i = 0; i < Nnue::halfDimensions; i += 16 )
+	{
+		__m256i* a = reinterpret_cast<__m256i*>( &acc[i] );
+		_mm256_store_si256( a, _mm256_add_epi16( _mm256_load_si256( a ), _mm256_load_si256( reinterpret_cast<const __m256i*>( &row[i] ) ) ) );
+	}
+#else
+	for( unsigned int i = 0; i < Nnue::halfDimensions; ++i )
+	{
+		acc[i] += row[i];
+	}
+#endif
+}
+
+static inline void subRow(int16_t* const acc, const int16_t* const row)
+{
+#ifdef __AVX2__
+	for( unsigned int i = 0; i < Nnue::halfDimensions; i += 16 )
+	{
+		__m256i* a = reinterpret_cast<__m256i*>( &acc[i] );
+		_mm256_store_si256( a, _mm256_sub_epi16( _mm256_load_si256( a ), _mm256_load_si256( reinterpret_cast<const __m256i*>( &row[i] ) ) ) );
+	}
+#else
+	for( unsigned int i = 0; i < Nnue::halfDimensions; ++i )
+	{
+		acc[i] -= row[i];
+	}
+#endif
+}
+
+void Nnue::refreshAccumulator(const Position& pos, nnueAccumulator& acc, const Color perspective) const
+{
+	assert( _net );
+	const tSquare ksq = pos.getSquareOfThePiece( perspective == white ? whiteKing : blackKing );
+	int16_t* const values = acc.values[perspective];
+
+	std::memcpy( values, _net->featureBiases, sizeof(_net->featureBiases) );
+	bitMap b = pos.getOccupationBitmap() & ~( pos.getBitmap( whiteKing ) | pos.getBitmap( blackKing ) );
+	while( b )
+	{
+		const tSquare sq = iterateBit( b );
+		addRow( values, _net->featureWeights[ getFeatureIndex( perspective, ksq, pos.getPieceAt( sq ), sq ) ] );
+	}
+	acc.computed[perspective] = true;
+}
+
+void Nnue::updateAccumulator(const nnueAccumulator& parent, nnueAccumulator& acc, const Color perspective, const tSquare kingSquare) const
+{
+	assert( _net );
+	assert( parent.computed[perspective] );
+	int16_t* const values = acc.values[perspective];
+
+	std::memcpy( values, parent.values[perspective], sizeof(acc.values[perspective]) );
+	const nnueDirtyPieces& d = acc.dirty;
+	for( unsigned int i = 0; i < d.count; ++i )
+	{
+		if( isKing( d.piece[i] ) )
+		{
+			continue;
+		}
+		if( d.from[i] != squareNone )
+		{
+			subRow( values, _net->featureWeights[ getFeatureIndex( perspective, kingSquare, d.piece[i], d.from[i] ) ] );
+		}
+		if( d.to[i] != squareNone )
+		{
+			addRow( values, _net->featureWeights[ getFeatureIndex( perspective, kingSquare, d.piece[i], d.to[i] ) ] );
+		}
+	}
+	acc.computed[perspective] = true;
+}
+
+/*! \brief bring stack[current] up to date, starting from the nearest computed ancestor.
+	when the king of the perspective has moved, or there is no usable ancestor, the accumulator is refreshed from scratch
+*/
+void Nnue::_computeAccumulator(const Position& pos, std::vector<nnueAccumulator>& stack, const unsigned int current, const Color perspective) const
+{
+	const bitboardIndex ourKing = perspective == white ? whiteKing : blackKing;
+	unsigned int i = current;
+	while( !stack[i].computed[perspective] )
+	{
+		const nnueAccumulator& acc = stack[i];
+		bool kingMoved = false;
+		for( unsigned int n = 0; n < acc.dirty.count; ++n )
+		{
+			kingMoved |= acc.dirty.piece[n] == ourKing;
+		}
+		if( i == 0 || !acc.fromParent || kingMoved )
+		{
+			refreshAccumulator( pos, stack[current], perspective );
+			return;
+		}
+		--i;
+	}
+
+	const tSquare ksq = pos.getSquareOfThePiece( ourKing );
+	for( ++i; i <= current; ++i )
+	{
+		updateAccumulator( stack[i - 1], stack[i], perspective, ksq );
+	}
+}
+
+/*! \brief clipped relu of the accumulator, from int16 to [0, 127]
+*/
+static inline void transform(const int16_t* const acc, uint8_t* const out)
+{
+#ifdef __AVX2__
+	const __m256i zero = _mm256_setzero_si256();
+	for( unsigned int i = 0; i < Nnue::halfDimensions; i += 32 )
+	{
+		const __m256i a = _mm256_load_si256( reinterpret_cast<const __m256i*>( &acc[i] ) );
+		const __m256i b = _mm256_load_si256( reinterpret_cast<const __m256i*>( &acc[i + 16] ) );
+		// packs works on 128 bits lanes, the permutation restores the order of the values
+		const __m256i packed = _mm256_permute4x64_epi64( _mm256_max_epi8( _mm256_packs_epi16( a, b ), zero ), 0xD8 );
+		_mm256_store_si256( reinterpret_cast<__m256i*>( &out[i] ), packed );
+	}
+#else
+	for( unsigned int i = 0; i < Nnue::halfDimensions; ++i )
+	{
+		out[i] = (uint8_t)std::clamp<int16_t>( acc[i], 0, 127 );
+	}
+#endif
+}
+
+/*! \brief dot product of the uint8 inputs with the int8 weights, size shall be a multiple of 32
+*/
+static inline int32_t dotProduct(const uint8_t* const in, const int8_t* const w, const unsigned int size)
+{
+#ifdef __AVX2__
+	const __m256i ones = _mm256_set1_epi16( 1 );
+	__m256i sum = _mm256_setzero_si256();
+	for( unsigned int i = 0; i < size; i += 32 )
+	{
+		// inputs are at most 127, so the sum of two adjacent products can't saturate
+		const __m256i products = _mm256_maddubs_epi16( _mm256_load_si256( reinterpret_cast<const __m256i*>( &in[i] ) ), _mm256_load_si256( reinterpret_cast<const __m256i*>( &w[i] ) ) );
+		sum = _mm256_add_epi32( sum, _mm256_madd_epi16( products, ones ) );
+	}
+	__m128i s = _mm_add_epi32( _mm256_castsi256_si128( sum ), _mm256_extracti128_si256( sum, 1 ) );
+	s = _mm_add_epi32( s, _mm_shuffle_epi32( s, 0x4E ) );
+	s = _mm_add_epi32( s, _mm_shuffle_epi32( s, 0xB1 ) );
+	return _mm_cvtsi128_si32( s );
+#else
+	int32_t sum = 0;
+	for( unsigned int i = 0; i < size; ++i )
+	{
+		sum += in[i] * w[i];
+	}
+	return sum;
+#endif
+}
+
+template<unsigned int inputs, unsigned int outputs>
+static inline void hiddenLayer(const uint8_t* const in, const int8_t (* const weights)[inputs], const int32_t* const biases, uint8_t* const out)
+{
+	static_assert( inputs % 32 == 0, "the layer inputs shall be a multiple of 32" );
+	for( unsigned int i = 0; i < outputs; ++i )
+	{
+		out[i] = (uint8_t)std::clamp( ( biases[i] + dotProduct( in, weights[i], inputs ) ) >> weightsShift, 0, 127 );
+	}
+}
+
+Score Nnue::evaluate(const Position& pos, std::vector<nnueAccumulator>& stack, const unsigned int current) const
+{
+	assert( _net );
+	assert( current < stack.size() );
+	_computeAccumulator( pos, stack, current, white );
+	_computeAccumulator( pos, stack, current, black );
+
+	const nnueAccumulator& acc = stack[current];
+	const Color us = pos.isBlackTurn() ? black : white;
+
+	alignas(32) uint8_t input[2 * halfDimensions];
+	alignas(32) uint8_t hidden1[hiddenDimensions];
+	alignas(32) uint8_t hidden2[hiddenDimensions];
+
+	transform( acc.values[us], input );
+	transform( acc.values[us == white ? black : white], input + halfDimensions );
+	hiddenLayer<2 * halfDimensions, hiddenDimensions>( input, _net->hidden1Weights, _net->hidden1Biases, hidden1 );
+	hiddenLayer<hiddenDimensions, hiddenDimensions>( hidden1, _net->hidden2Weights, _net->hidden2Biases, hidden2 );
+	const int32_t output = _net->outputBias + dotProduct( hidden2, _net->outputWeights, hiddenDimensions );
+
+	// the output is expressed in 1/16 of centipawn, a net can't claim a known win
+	return (Score)std::clamp<int64_t>( (int64_t)output * 25 / 4, -SCORE_KNOWN_WIN + 1, SCORE_KNOWN_WIN - 1 );
+}
@@ -0,0 +1,129 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef NNUE_H_
+#define NNUE_H_
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bitBoardIndex.h"
+#include "score.h"
+#include "eCastle.h"
+#include "tSquare.h"
+
+class Position;
+
+/*! \brief pieces changed by a move, used to update the accumulator from the one of the previous ply
+	a piece with to == squareNone has been removed, a piece with from == squareNone has been added.
+	a move changes at most 4 pieces: a capture promotion moves the pawn, removes it, adds the promoted piece and removes the captured one
+*/
+struct nnueDirtyPieces
+{
+	unsigned int count;
+	bitboardIndex piece[4];
+	tSquare from[4];
+	tSquare to[4];
+
+	void add(const bitboardIndex p, const tSquare f, const tSquare t)
+	{
+		piece[count] = p;
+		from[count] = f;
+		to[count] = t;
+		++count;
+	}
+};
+
+/*! \brief first layer output of both the perspectives, one for each state of the position.
+	The accumulator is computed lazily, when the position is evaluated.
+*/
+class alignas(32) nnueAccumulator
+{
+public:
+	static constexpr unsigned int halfDimensions = 128;
+
+	int16_t values[2][halfDimensions];
+	bool computed[2];
+	bool fromParent;	/*!< the accumulator can be computed from the one of the previous ply applying dirty*/
+	nnueDirtyPieces dirty;
+};
+
+/*! \brief efficiently updatable neural network evaluation
+
+	HalfKP input: for each perspective the features are (king square, piece, square) of every non king piece, 40960 inputs
+	feeding the 2x128 int16 accumulator. The accumulator of the side to move and the other one are clipped to [0, 127]
+	and go through two 32 neurons int8 layers and the int8 output neuron.
+	The net is loaded from a file, when no net is loaded the classical evaluation is used.
+*/
+class Nnue
+{
+public:
+	static constexpr unsigned int inputDimensions = 64 * 10 * 64;
+	static constexpr unsigned int halfDimensions = nnueAccumulator::halfDimensions;
+	static constexpr unsigned int hiddenDimensions = 32;
+
+	/*! \brief net file layout, all the values are little endian
+		header: magic "VAJONNUE", uint32 version, uint32 halfDimensions, uint32 hiddenDimensions
+		int16 featureBiases[halfDimensions], int16 featureWeights[inputDimensions][halfDimensions]
+		int32 hidden1Biases[hiddenDimensions], int8 hidden1Weights[hiddenDimensions][2 * halfDimensions]
+		int32 hidden2Biases[hiddenDimensions], int8 hidden2Weights[hiddenDimensions][hiddenDimensions]
+		int32 outputBias, int8 outputWeights[hiddenDimensions]
+	*/
+	static const char fileMagic[8];
+	static constexpr uint32_t fileVersion = 1;
+
+	static Nnue& getInstance()
+	{
+		static Nnue instance; // Guaranteed to be destroyed.
+		// Instantiated on first use.
+		return instance;
+	}
+
+	bool loadFromFile(const std::string& path);
+	void unload();
+	bool isLoaded() const { return (bool)_net; }
+	/*! \brief identifier of the loaded net, 0 if no net is loaded. it changes every time a net is loaded
+	*/
+	unsigned int getId() const { return _id; }
+
+	static unsigned int getFeatureIndex(const Color perspective, const tSquare kingSquare, const bitboardIndex piece, const tSquare sq);
+
+	void refreshAccumulator(const Position& pos, nnueAccumulator& acc, const Color perspective) const;
+	void updateAccumulator(const nnueAccumulator& parent, nnueAccumulator& acc, const Color perspective, const tSquare kingSquare) const;
+	/*! \brief evaluate the position from the side to move point of view, stack[current] is the accumulator of the position
+	*/
+	Score evaluate(const Position& pos, std::vector<nnueAccumulator>& stack, const unsigned int current) const;
+
+private:
+	struct network;
+
+	Nnue();
+	~Nnue();
+	Nnue(const Nnue&) = delete;
+	Nnue& operator=(const Nnue&) = delete;
+
+	void _computeAccumulator(const Position& pos, std::vector<nnueAccumulator>& stack, const unsigned int current, const Color perspective) const;
+
+	std::unique_ptr<network> _net;
+	unsigned int _id = 0;
+	unsigned int _loadCount = 0;
+};
+
+#endif /* NNUE_H_ */
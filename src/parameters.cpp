@@ -193,3 +193,10 @@ simdScore mobilityBonus[separationBitmap][32] = {
 	  {1551,909},{2079,1010},{1830,1234},{1793,603}
 	}
 };
+
+//------------------------------------------------
+//lazy eval
+//------------------------------------------------
+// indexed by game phase: opening .. endgame
+// 99th percentile of the error measured on bench positions, the lazy eval is disabled by default (LazyEval option)
+Score lazyEvalMargin[5] = {80000, 80000, 55000, 30000, 40000};
@@ -126,6 +126,11 @@ extern simdScore queenVsRook2MinorsImbalance;
 
 extern simdScore mobilityBonus[separationBitmap][32];
 
+//------------------------------------------------
+//lazy eval
+//------------------------------------------------
+extern Score lazyEvalMargin[5];
+
 
 
 
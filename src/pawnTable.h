@@ -20,76 +20,83 @@
 #define TABLES_H_
 
 
-#include <array>
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
-#include "bitBoardIndex.h"
 #include "bitops.h"
 #include "hashKey.h"
 #include "score.h"
+#include "searchStatistics.h"
 
-class pawnEntry
+/*! \brief pawn hash entry
+	only the data that can't be cheaply recalculated from the pawn bitmaps is saved: pawn attacks, weak squares
+	and holes are shifts of the pawn bitmaps and are computed again on a hit.
+*/
+class alignas(32) pawnEntry
 {
 public:
-	HashKey key;
+	uint64_t key;
 	bitMap weakPawns;
 	bitMap passedPawns;
-	bitMap pawnAttacks[2];
-	bitMap weakSquares[2];
-	bitMap holes[2];
 	Score res[2];
 };
 
+static_assert(sizeof(pawnEntry) == 32, "two pawnEntry shall fit a cache line");
+
 class pawnTable
 {
 public:
+	explicit pawnTable(): _table(_configuredSize), _mask(_configuredSize - 1){}
+
+	/*! \brief set the size of the tables, rounded down to a power of two entries
+		the tables already created are resized by updateSize
+	*/
+	static unsigned long int setSize(const unsigned long int mbSize)
+	{
+		const unsigned long int entries = std::max( 1ul, ( mbSize << 20 ) / sizeof(pawnEntry) );
+		_configuredSize = 1ul << ( 63 - __builtin_clzll( entries ) );
+		return _configuredSize;
+	}
+
+	void updateSize()
+	{
+		if( _table.size() != _configuredSize )
+		{
+			_table.assign( _configuredSize, pawnEntry() );
+			_mask = _configuredSize - 1;
+		}
+	}
+
 	void insert(
 		const HashKey& key,
 		const simdScore res,
 		const bitMap weakPawns,
-		const bitMap passedPawns,
-		const bitMap* const attackedSquares,
-		const bitMap* const weakSquares,
-		const bitMap* const holes) {
+		const bitMap passedPawns) {
 
 		pawnEntry& x = _probe(key);
 
-		x.key = key;
+		x.key = key.getKey();
 		x.res[0] = res[0];
 		x.res[1] = res[1];
 
 		x.weakPawns = weakPawns;
 		x.passedPawns = passedPawns;
-
-		x.pawnAttacks[0] = attackedSquares[whitePawns];
-		x.pawnAttacks[1] = attackedSquares[blackPawns];
-		
-		x.weakSquares[0] = weakSquares[white];
-		x.weakSquares[1] = weakSquares[black];
-		x.holes[0] = holes[white];
-		x.holes[1] = holes[black];
 	}
 	
 	bool getValues(
 		const HashKey& pawnKey,
 		simdScore& res,
 		bitMap& weakPawns,
-		bitMap& passedPawns,
-		bitMap *const attackedSquares,
-		bitMap * const weakSquares,
-		bitMap * const holes) const {
+		bitMap& passedPawns) const {
 	
 	const pawnEntry& probePawn = _probe(pawnKey);
 	
-	if (probePawn.key == pawnKey) {
+	searchStatistics::increment(searchStatistics::pawnProbes);
+	if (probePawn.key == pawnKey.getKey()) {
+		searchStatistics::increment(searchStatistics::pawnHits);
 		weakPawns = probePawn.weakPawns;
 		passedPawns = probePawn.passedPawns;
-		attackedSquares[whitePawns] = probePawn.pawnAttacks[0];
-		attackedSquares[blackPawns] = probePawn.pawnAttacks[1];
-		weakSquares[white] = probePawn.weakSquares[0];
-		weakSquares[black] = probePawn.weakSquares[1];
-		holes[white] = probePawn.holes[0];
-		holes[black] = probePawn.holes[1];
 		res = simdScore{probePawn.res[0], probePawn.res[1], 0, 0};
 		return true;
 	} else {
@@ -97,11 +104,12 @@ public:
 	}
 }
 private:
-	static const int _size = 8192;
-	unsigned int _getIndex( const HashKey& key ) const { return ( (unsigned int)key.getKey() ) % _size; }
-	const pawnEntry& _probe(const HashKey& key) const { return _pawnTable[_getIndex(key)]; }
-	pawnEntry& _probe(const HashKey& key) { return _pawnTable[_getIndex(key)]; }
-	std::array<pawnEntry,_size> _pawnTable;
+	static inline unsigned long int _configuredSize = 32768;
+	std::vector<pawnEntry> _table;
+	unsigned long int _mask;
+	unsigned long int _getIndex( const HashKey& key ) const { return key.getKey() & _mask; }
+	const pawnEntry& _probe(const HashKey& key) const { return _table[_getIndex(key)]; }
+	pawnEntry& _probe(const HashKey& key) { return _table[_getIndex(key)]; }
 };
 
 #endif /* TABLES_H_ */
@@ -16,12 +16,16 @@
     along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
 */
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "command.h"
 #include "vajo_io.h"
-#include "movepicker.h"
+#include "moveList.h"
 #include "perft.h"
+#include "perftTable.h"
 #include "position.h"
-#include "transposition.h"
 #include "vajolet.h"
 
 
@@ -40,28 +44,31 @@ unsigned long long Perft::perft(unsigned int depth)
 	if (depth == 0) {
 		return 1;
 	}
+#else
+	if (depth == 0) {
+		return 1;
+	}
+	// bulk counting: the leaves are counted by the move generator without playing them, and they aren't worth an hash access
+	if(depth==1)
+	{
+		return _pos.getNumberOfLegalMoves();
+	}
 #endif
-	PerftTranspositionTable tt;
+	PerftTranspositionTable& tt = PerftTranspositionTable::getInstance();
 	
 	unsigned long long tot;
 	if( perftUseHash && tt.retrieve(_pos.getKey(), depth, tot) )
 	{
 		return tot;
 	}
-	
-#ifdef FAST_PERFT
-	
-	if(depth==1)
-	{
-		return _pos.getNumberOfLegalMoves();
-	}
-#endif
 
 	tot = 0;
-	Move m;
-	MovePicker mp(_pos);
-	while( ( m = mp.getNextMove() ) )
+	// perft doesn't need any move ordering, the moves are taken straight from the legal move generator
+	MoveList<MAX_MOVE_PER_POSITION> ml;
+	_pos.getLegalMoves( ml );
+	for( auto& m: ml )
 	{
+		assert( _pos.isMoveLegal( m ) );
 		_pos.doMove(m);
 		tot += perft(depth - 1);
 		_pos.undoMove();
@@ -76,36 +83,123 @@ unsigned long long Perft::perft(unsigned int depth)
 
 }
 
+/*! \brief calculate the perft result using several threads
+*/
+unsigned long long Perft::perft(unsigned int depth, unsigned int threads)
+{
+	std::vector<Move> rootMoves;
+	std::vector<unsigned long long> rootCounts;
+	return _parallelPerft(depth, threads, rootMoves, rootCounts);
+}
+
 /*! \brief calculate the divide result
 	\author Marco Belli
 	\version 1.0
 	\date 08/11/2013
 */
-unsigned long long Perft::divide(unsigned int depth)
+unsigned long long Perft::divide(unsigned int depth, unsigned int threads)
 {
+	std::vector<Move> rootMoves;
+	std::vector<unsigned long long> rootCounts;
+	unsigned long long tot = _parallelPerft(depth, threads, rootMoves, rootCounts);
 
+	for( unsigned int mn = 0; mn < rootMoves.size(); ++mn )
+	{
+		sync_cout<<mn + 1<<") "<<UciManager::displayMove(_pos, rootMoves[mn])<<": "<<rootCounts[mn]<<sync_endl;
+	}
+	return tot;
 
-	MovePicker mp(_pos);
-	unsigned long long tot = 0;
-	unsigned int mn=0;
-	Move m;
-	while ( ( m = mp.getNextMove() ) )
+}
+
+/*! \brief split the perft tree in small jobs and run them on several threads
+	the tree is split at ply 2 ( at the root for shallow perft ), the jobs are assigned dynamically
+	to the threads so the ones that finish early take the remaining work. the perft hash is shared.
+	no more threads than the hardware ones are started
+*/
+unsigned long long Perft::_parallelPerft(unsigned int depth, unsigned int threads, std::vector<Move>& rootMoves, std::vector<unsigned long long>& rootCounts)
+{
+	rootMoves.clear();
+	rootCounts.clear();
+	if( depth == 0 )
 	{
-		mn++;
-		_pos.doMove(m);
-		unsigned long long n= 1;
-		if( depth>1)
+		return 1;
+	}
+	threads = std::min( std::max( threads, 1u ), std::max( std::thread::hardware_concurrency(), 1u ) );
+
+	struct perftJob
+	{
+		unsigned int rootIndex;
+		Move root;
+		Move reply;
+	};
+
+	const unsigned int splitPly = depth >= 3 ? 2 : 1;
+	std::vector<perftJob> jobs;
+
+	MoveList<MAX_MOVE_PER_POSITION> ml;
+	_pos.getLegalMoves( ml );
+	for( auto& m: ml )
+	{
+		const unsigned int rootIndex = rootMoves.size();
+		rootMoves.push_back(m);
+		if( splitPly == 1 )
 		{
-			n= perft(depth - 1);
+			jobs.push_back( { rootIndex, m, Move::NOMOVE } );
+			continue;
 		}
-		else
+		_pos.doMove(m);
+		MoveList<MAX_MOVE_PER_POSITION> replies;
+		_pos.getLegalMoves( replies );
+		for( auto& r: replies )
 		{
-			n= 1;
+			jobs.push_back( { rootIndex, m, r } );
 		}
-		tot += n;
 		_pos.undoMove();
-		sync_cout<<mn<<") "<<UciManager::displayMove(_pos, m)<<": "<<n<<sync_endl;
 	}
-	return tot;
 
-}
\ No newline at end of file
+	std::vector<std::atomic<unsigned long long>> counts( rootMoves.size() );
+	std::atomic<size_t> nextJob(0);
+
+	auto worker = [&]()
+	{
+		Position pos( _pos, Position::pawnHash::off );
+		Perft pft( pos );
+		for( size_t j; ( j = nextJob++ ) < jobs.size(); )
+		{
+			const perftJob& job = jobs[j];
+			pos.doMove( job.root );
+			if( job.reply )
+			{
+				pos.doMove( job.reply );
+			}
+
+			const unsigned long long n = depth > splitPly ? pft.perft( depth - splitPly ) : 1;
+
+			if( job.reply )
+			{
+				pos.undoMove();
+			}
+			pos.undoMove();
+			counts[ job.rootIndex ] += n;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for( unsigned int i = 1; i < threads; ++i )
+	{
+		workers.emplace_back( worker );
+	}
+	worker();
+	for( auto& t: workers )
+	{
+		t.join();
+	}
+
+	unsigned long long tot = 0;
+	for( auto& c: counts )
+	{
+		rootCounts.push_back( c );
+		tot += c;
+	}
+	return tot;
+}
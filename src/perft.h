@@ -18,6 +18,10 @@
 #ifndef PERFT_H_
 #define PERFT_H_
 
+#include <vector>
+
+#include "move.h"
+
 class Position;
 
 class Perft
@@ -27,10 +31,12 @@ public:
 	
 	explicit Perft( Position & pos ): _pos(pos){}
 	unsigned long long perft(unsigned int depth);
-	unsigned long long divide(unsigned int depth);
+	unsigned long long perft(unsigned int depth, unsigned int threads);
+	unsigned long long divide(unsigned int depth, unsigned int threads = 1);
 
 private:
 	Position & _pos;
+	unsigned long long _parallelPerft(unsigned int depth, unsigned int threads, std::vector<Move>& rootMoves, std::vector<unsigned long long>& rootCounts);
 };
 
 #endif /* PERFT_H_ */
@@ -0,0 +1,91 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+#include <iostream>
+
+#include "hashKey.h"
+#include "perftTable.h"
+
+
+unsigned long int PerftTranspositionTable::setSize(unsigned long int mbSize)
+{
+	_elements = std::max( 1ul, (unsigned long int)( ((unsigned long long int)mbSize << 20) / sizeof(perftCluster) ) );
+
+	_table.clear();
+	_table.shrink_to_fit();
+	try
+	{
+		_table.resize(_elements);
+	}
+	catch(...)
+	{
+		std::cerr << "Failed to allocate " << mbSize<< "MB for perft hash table." << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	return _elements * 4;
+}
+
+void PerftTranspositionTable::clear()
+{
+	std::fill(_table.begin(), _table.end(), perftCluster());
+}
+
+void PerftTranspositionTable::store(const HashKey& key, unsigned int depth, unsigned long long v)
+{
+	const uint64_t keyDepth = perftEntry::packKeyDepth( key.getKey(), depth );
+	perftCluster& pc = _table[ _getClusterIndex( key.getKey() ) ];
+
+	// overwrite the same position or an empty slot, otherwise replace the shallowest entry: it has the smallest subtree
+	perftEntry* candidate = &pc[0];
+	unsigned int candidateDepth = 256;
+	for( auto& e: pc )
+	{
+		uint64_t k, count;
+		e.load( k, count );
+		const unsigned int d = k & 0xFF;
+		if( k == keyDepth || d == 0 )
+		{
+			candidate = &e;
+			break;
+		}
+		if( d < candidateDepth )
+		{
+			candidate = &e;
+			candidateDepth = d;
+		}
+	}
+	candidate->save( keyDepth, v );
+}
+
+bool PerftTranspositionTable::retrieve(const HashKey& key, unsigned int depth, unsigned long long& res) const
+{
+	const uint64_t keyDepth = perftEntry::packKeyDepth( key.getKey(), depth );
+	const perftCluster& pc = _table[ _getClusterIndex( key.getKey() ) ];
+
+	for( auto& e: pc )
+	{
+		uint64_t k, count;
+		e.load( k, count );
+		if( k == keyDepth )
+		{
+			res = count;
+			return true;
+		}
+	}
+	return false;
+}
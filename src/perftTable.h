@@ -0,0 +1,104 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef PERFT_TABLE_H_
+#define PERFT_TABLE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class HashKey;
+
+/*! \brief lock-free perft hash entry
+	the count is stored with full 64 bits, the depth lives in the low byte of the key.
+	the key is xored with the count so a torn entry fails the verification.
+*/
+class perftEntry
+{
+private:
+	std::atomic<uint64_t> _keyDepth;	/*! 56 bit key | 8 bit depth, xored with the count*/
+	std::atomic<uint64_t> _count;		/*! 64 bit node count*/
+
+public:
+	explicit perftEntry(): _keyDepth(0), _count(0){}
+	perftEntry(const perftEntry& other): _keyDepth(other._keyDepth.load(std::memory_order_relaxed)), _count(other._count.load(std::memory_order_relaxed)){}
+	perftEntry& operator=(const perftEntry& other)
+	{
+		_keyDepth.store(other._keyDepth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_count.store(other._count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return *this;
+	}
+
+	static uint64_t packKeyDepth(const uint64_t key, const unsigned int depth) { return ( key & ~0xFFull ) | ( depth & 0xFF ); }
+
+	inline void load(uint64_t& keyDepth, uint64_t& count) const
+	{
+		const uint64_t k = _keyDepth.load(std::memory_order_relaxed);
+		count = _count.load(std::memory_order_relaxed);
+		keyDepth = k ^ count;
+	}
+	inline void save(const uint64_t keyDepth, const uint64_t count)
+	{
+		_count.store(count, std::memory_order_relaxed);
+		_keyDepth.store(keyDepth ^ count, std::memory_order_relaxed);
+	}
+};
+
+struct alignas(64) perftCluster: public std::array<perftEntry, 4>
+{
+};
+
+static_assert(sizeof(perftCluster) == 64, "a perftCluster shall fit a cache line");
+
+/*! \brief hash table used by perft, separated from the search transposition table
+*/
+class PerftTranspositionTable
+{
+public:
+	static PerftTranspositionTable& getInstance()
+	{
+		static PerftTranspositionTable instance; // Guaranteed to be destroyed.
+		// Instantiated on first use.
+		return instance;
+	}
+
+	unsigned long int setSize(unsigned long int mbSize);
+	void clear();
+	void store(const HashKey& key, unsigned int depth, unsigned long long v);
+	bool retrieve(const HashKey& key, unsigned int depth, unsigned long long& res) const;
+
+private:
+	std::vector<perftCluster> _table;
+	unsigned long int _elements;
+
+	explicit PerftTranspositionTable()
+	{
+		setSize(1);
+	}
+
+	PerftTranspositionTable(PerftTranspositionTable const&) = delete;
+	void operator=(PerftTranspositionTable const&) = delete;
+
+	inline size_t _getClusterIndex(uint64_t key) const
+	{
+		__extension__ using uint128 = unsigned __int128;
+		return static_cast<size_t>( ( (uint128)key * (uint128)_elements ) >> 64 );
+	}
+};
+
+#endif /* PERFT_TABLE_H_ */
@@ -20,7 +20,9 @@
 #include "vajo_io.h"
 #include "parameters.h"
 #include "position.h"
+#include "evalTable.h"
 #include "pawnTable.h"
+#include "transposition.h"
 #include "uciParameters.h"
 #include "vajolet.h"
 
@@ -320,6 +322,19 @@ const Position& Position::setupFromFen(const std::string& fenStr)
 	
 	//initCastleRightsMask();
 
+	// select once the castle code used by move generation, doMove and undoMove
+	_isStandardCastling = true;
+	for( const eCastle cr : { wCastleOO, wCastleOOO, bCastleOO, bCastleOOO } )
+	{
+		if( x.hasCastleRight( cr )
+			&& ( _castleRookInvolved[cr] != _standardCastleRookInvolved[cr]
+				|| _castlePath[cr] != _standardCastlePath[cr]
+				|| _castleKingPath[cr] != _standardCastleKingPath[cr] ) )
+		{
+			_isStandardCastling = false;
+		}
+	}
+
 	x.resetEpSquare();
 	if (((ss >> col) && (col >= 'a' && col <= 'h'))
 		&& ((ss >> row) && (row == '3' || row == '6')))
@@ -432,8 +447,8 @@ void Position::clear()
 	{
 		_bitBoard[i] = 0;
 	}
-	_stateInfo.clear();
-	_stateInfo.emplace_back(state());
+	_stateInfo.reset();
+	resetNnueStack();
 
 }
 
@@ -580,7 +595,6 @@ std::string  Position::getFen() const {
 	return s;
 }
 
-#ifdef DEBUG_EVAL_SIMMETRY
 std::string Position::getSymmetricFen() const {
 
 	std::string s;
@@ -660,7 +674,6 @@ std::string Position::getSymmetricFen() const {
 
 	return s;
 }
-#endif
 
 /*! \brief calc the hash key of the position
 	\author Marco Belli
@@ -792,16 +805,23 @@ simdScore Position::calcNonPawnMaterialValue() const
 void Position::doNullMove()
 {
 
-	insertState(getActualState());
+	insertState();
 	state &x = getActualState();
+	if( _nnueId )
+	{
+		insertNnueAccumulator();
+	}
 
 	x.setCurrentMove( Move::NOMOVE );
+	// the null move is never done while in check
+	x.setCheckers( 0 );
 	if( x.hasEpSquare() )
 	{
 		x.getKey().changeEp( x.getEpSquare() );
 		x.resetEpSquare();
 	}
 	x.getKey().changeSide();
+	transpositionTable::getInstance().prefetch( x.getKey().getKey() );
 	x.incrementIrreversibleMoveCount();
 	x.resetPliesFromNullCount();
 	x.changeNextTurn();
@@ -830,6 +850,104 @@ void Position::doNullMove()
 */
 void Position::doMove(const Move & m)
 {
+	if( isBlackTurn() )
+	{
+		_doMove<black>( m );
+	}
+	else
+	{
+		_doMove<white>( m );
+	}
+}
+
+/*! \brief move king and rook of a castle move of the player c
+	\tparam standard the castle squares are the ones of standard chess
+*/
+template<Color c, bool standard>
+inline void Position::_doCastle(const Move &m, state& x, nnueDirtyPieces& dirty)
+{
+	constexpr bitboardIndex ourKing = c == white ? whiteKing : blackKing;
+	constexpr bitboardIndex ourRooks = c == white ? whiteRooks : blackRooks;
+
+	const eCastle cs = state::calcCastleRight(m.isKingSideCastle() ? castleOO: castleOOO, c);
+
+	const tSquare rFrom = getCastleRookInvolved<standard>(cs);
+	assert(rFrom<squareNumber);
+	assert( getPieceAt(rFrom) == ourRooks );
+
+	const tSquare rTo = getCastleRookFinalSquare<standard>(cs);
+	assert(rTo<squareNumber);
+
+	const tSquare kFrom = m.getFrom();
+	const tSquare kTo  = getCastleKingFinalSquare<standard>(cs);
+	assert(kFrom<squareNumber);
+	assert(kTo<squareNumber);
+	assert( getPieceAt(kFrom) == ourKing );
+
+	removePiece(ourRooks, rFrom);
+	// in standard chess the king always moves
+	if( standard || kFrom != kTo )
+	{
+		movePiece( ourKing, kFrom, kTo );
+	}
+	putPiece(ourRooks, rTo);
+	dirty.add( ourKing, kFrom, kTo );
+	dirty.add( ourRooks, rFrom, rTo );
+
+	x.getKey().updatePiece( rFrom, ourRooks );
+	x.getKey().updatePiece( rTo, ourRooks );
+	x.getKey().updatePiece( kFrom, ourKing );
+	x.getKey().updatePiece( kTo, ourKing );
+
+	x.addMaterial( _pstValue[ourRooks][rTo] - _pstValue[ourRooks][rFrom] );
+	x.addMaterial( _pstValue[ourKing][kTo] - _pstValue[ourKing][kFrom] );
+}
+
+/*! \brief undo the king and rook movement of a castle move of the player c
+	\tparam standard the castle squares are the ones of standard chess
+*/
+template<Color c, bool standard>
+inline void Position::_undoCastle(const Move &m)
+{
+	constexpr bitboardIndex ourKing = c == white ? whiteKing : blackKing;
+	constexpr bitboardIndex ourRooks = c == white ? whiteRooks : blackRooks;
+
+	const eCastle cs = state::calcCastleRight(m.isKingSideCastle() ? castleOO: castleOOO, c);
+
+	const tSquare rFrom = getCastleRookInvolved<standard>(cs);
+	const tSquare rTo = getCastleRookFinalSquare<standard>(cs);
+
+	const tSquare kFrom = m.getFrom();
+	const tSquare kTo = getCastleKingFinalSquare<standard>(cs);
+
+	assert(rFrom < squareNumber);
+	assert(rTo < squareNumber);
+	assert(kFrom < squareNumber);
+	assert(kTo < squareNumber);
+	assert( getPieceAt(rTo) == ourRooks );
+	assert( getPieceAt(kTo) == ourKing );
+
+	removePiece(ourRooks, rTo);
+	if( standard || kFrom != kTo )
+	{
+		movePiece( ourKing, kTo, kFrom );
+	}
+	putPiece(ourRooks, rFrom);
+}
+
+/*! \brief do a move of the player c, the side to move is a compile time constant
+*/
+template<Color c>
+inline void Position::_doMove(const Move & m)
+{
+	constexpr bitboardIndex theirKing = c == white ? blackKing : whiteKing;
+	constexpr bitboardIndex ourQueens = c == white ? whiteQueens : blackQueens;
+	constexpr bitboardIndex ourRooks = c == white ? whiteRooks : blackRooks;
+	constexpr bitboardIndex ourBishops = c == white ? whiteBishops : blackBishops;
+	constexpr bitboardIndex ourPieces = c == white ? whitePieces : blackPieces;
+	constexpr bitboardIndex ourPawns = c == white ? whitePawns : blackPawns;
+	constexpr bitboardIndex theirPawns = c == white ? blackPawns : whitePawns;
+
 #ifdef	ENABLE_CHECK_CONSISTENCY
 	if( ! isMoveLegal(m) )
 	{
@@ -841,8 +959,12 @@ void Position::doMove(const Move & m)
 
 	const bool moveIsCheck = moveGivesCheck(m);
 
-	insertState(getActualState());
+	insertState();
 	state &x = getActualState();
+	// without a net the changed pieces are recorded in a scratch variable, to keep the move code free of branches
+	nnueDirtyPieces unusedDirtyPieces;
+	unusedDirtyPieces.count = 0;
+	nnueDirtyPieces& dirty = _nnueId ? insertNnueAccumulator() : unusedDirtyPieces;
 
 	x.setCurrentMove( m );
 
@@ -851,7 +973,7 @@ void Position::doMove(const Move & m)
 	const bitboardIndex piece = getPieceAt(from);
 	assert( isValidPiece( piece ));
 
-	bitboardIndex captured = ( m.isEnPassantMove() ? (x.isBlackTurn() ? whitePawns : blackPawns ) : getPieceAt(to) );
+	bitboardIndex captured = ( m.isEnPassantMove() ? theirPawns : getPieceAt(to) );
 	assert( isValidPiece( captured ) || captured == empty );
 
 	// change side
@@ -872,37 +994,15 @@ void Position::doMove(const Move & m)
 	// do castle additional instruction
 	if( m.isCastleMove() )
 	{
-		Color color = x.isBlackTurn() ? black : white;
-		eCastle cs = state::calcCastleRight(m.isKingSideCastle() ? castleOO: castleOOO, color);
-		
-		tSquare rFrom = _castleRookInvolved[cs];
-		assert(rFrom<squareNumber);
-		bitboardIndex rook = getPieceAt(rFrom);
-		assert( isRook(rook) );
-		
-		tSquare rTo = _castleRookFinalSquare[cs];
-		assert(rTo<squareNumber);
-		
-		tSquare kFrom = from;
-		tSquare kTo  = _castleKingFinalSquare[cs];
-		assert(kFrom<squareNumber);
-		assert(kTo<squareNumber);
-		
-		removePiece(rook, rFrom);
-		if( kFrom != kTo )
+		// the castle tables of standard chess are compile time constants, chess960 ones are read from the position
+		if( _isStandardCastling )
 		{
-			movePiece( piece, kFrom, kTo );
+			_doCastle<c, true>( m, x, dirty );
+		}
+		else
+		{
+			_doCastle<c, false>( m, x, dirty );
 		}
-		putPiece(rook, rTo);
-		
-		x.getKey().updatePiece( rFrom, rook );
-		x.getKey().updatePiece( rTo, rook );
-		x.getKey().updatePiece( kFrom, piece );
-		x.getKey().updatePiece( kTo, piece );
-		
-		x.addMaterial( _pstValue[rook][rTo] - _pstValue[rook][rFrom] );
-		x.addMaterial( _pstValue[piece][kTo] - _pstValue[piece][kFrom] );
-
 	}
 	else 
 	{
@@ -914,7 +1014,7 @@ void Position::doMove(const Move & m)
 
 				if( m.isEnPassantMove() )
 				{
-					captureSquare-=pawnPush( x.isBlackTurn() );
+					captureSquare-=pawnPush( c );
 				}
 				assert(captureSquare<squareNumber);
 				x.getPawnKey().updatePiece( captureSquare, captured );
@@ -922,6 +1022,7 @@ void Position::doMove(const Move & m)
 
 			// remove piece
 			removePiece(captured,captureSquare);
+			dirty.add( captured, captureSquare, squareNone );
 			// update material
 			x.removeMaterial( _pstValue[captured][captureSquare] );
 			x.removeNonPawnMaterial( _nonPawnValue[captured] );
@@ -939,6 +1040,7 @@ void Position::doMove(const Move & m)
 		x.getKey().updatePiece( from, piece );
 		x.getKey().updatePiece( to, piece );
 		movePiece(piece, from, to);
+		dirty.add( piece, from, to );
 
 		x.addMaterial( _pstValue[piece][to] - _pstValue[piece][from] );
 	}
@@ -952,12 +1054,12 @@ void Position::doMove(const Move & m)
 		x.clearCastleRight( cr );
 	}
 
-	if(isPawn(piece))
+	if( piece == ourPawns )
 	{
 		// set en-passant
 		if(
 				abs(from-to)==16	// double push
-				&& (getAttackersTo((tSquare)((from+to)>>1))  & Them[Pawns])
+				&& (getAttackersTo((tSquare)((from+to)>>1))  & getBitmap(theirPawns))
 		)
 		{
 			x.setEpSquare( (tSquare)((from+to)>>1) );
@@ -965,11 +1067,13 @@ void Position::doMove(const Move & m)
 		}
 		else if( m.isPromotionMove() )
 		{
-			bitboardIndex promotedPiece = getPieceOfPlayer( m.getPromotedPiece(), x.getNextTurn() );
+			bitboardIndex promotedPiece = getPieceOfPlayer( m.getPromotedPiece(), c == white ? whiteTurn : blackTurn );
 			assert( isValidPiece(promotedPiece) );
 
 			removePiece(piece,to);
 			putPiece(promotedPiece,to);
+			dirty.add( piece, to, squareNone );
+			dirty.add( promotedPiece, squareNone, to );
 
 			x.addMaterial( _pstValue[promotedPiece][to] - _pstValue[piece][to] );
 			x.addNonPawnMaterial( _nonPawnValue[promotedPiece] );
@@ -986,6 +1090,9 @@ void Position::doMove(const Move & m)
 		x.resetIrreversibleMoveCount();
 	}
 
+	// the key is complete, the search will probe the child node as soon as doMove returns
+	transpositionTable::getInstance().prefetch( x.getKey().getKey() );
+
 	x.setCapturedPiece( captured );
 	x.changeNextTurn();
 
@@ -996,26 +1103,29 @@ void Position::doMove(const Move & m)
 	if(moveIsCheck)
 	{
 
+		const tSquare ksq = getSquareOfThePiece( theirKing );
 		if( !m.isStandardMove() )
 		{
-			assert( getSquareOfOurKing() <squareNumber);
-			x.addCheckers( getAttackersTo( getSquareOfOurKing() ) & Them[Pieces] );
+			assert( ksq <squareNumber);
+			x.addCheckers( getAttackersTo( ksq ) & getBitmap(ourPieces) );
 		}
 		else
 		{
-			if( isSquareSet( x.getCheckingSquares( piece ), to ) ) // should be old state, but checkingSquares has not been changed so far
+			// checking squares and hidden checkers of the position before the move
+			const state& prev = _stateInfo.previous();
+			if( isSquareSet( prev.getCheckingSquares( piece ), to ) )
 			{
 				x.addCheckers( bitSet(to) );
 			}
-			if( x.thereAreHiddenCheckers() && (x.isHiddenChecker( from ) ) )	// should be old state, but hiddenCheckersCandidate has not been changed so far
+			if( prev.thereAreHiddenCheckers() && (prev.isHiddenChecker( from ) ) )
 			{
-				if(!isRook(piece))
+				if( piece != ourRooks )
 				{
-					x.addCheckers( Movegen::attackFrom<whiteRooks>( getSquareOfOurKing(), getOccupationBitmap() ) & (Them[Queens] |Them[Rooks]) );
+					x.addCheckers( Movegen::attackFrom<whiteRooks>( ksq, getOccupationBitmap() ) & (getBitmap(ourQueens) | getBitmap(ourRooks)) );
 				}
-				if(!isBishop(piece))
+				if( piece != ourBishops )
 				{
-					x.addCheckers( Movegen::attackFrom<whiteBishops>( getSquareOfOurKing(), getOccupationBitmap() ) & (Them[Queens] |Them[Bishops]) );
+					x.addCheckers( Movegen::attackFrom<whiteBishops>( ksq, getOccupationBitmap() ) & (getBitmap(ourQueens) | getBitmap(ourBishops)) );
 				}
 			}
 		}
@@ -1039,6 +1149,24 @@ void Position::doMove(const Move & m)
 */
 void Position::undoMove()
 {
+	// the state is still the one after the move, the move has been done by the player not on move
+	if( isBlackTurn() )
+	{
+		_undoMove<white>();
+	}
+	else
+	{
+		_undoMove<black>();
+	}
+}
+
+/*! \brief undo a move of the player c
+*/
+template<Color c>
+inline void Position::_undoMove()
+{
+	constexpr bitboardIndex ourPawns = c == white ? whitePawns : blackPawns;
+
 	--_ply;
 
 	const state& x = getActualState();
@@ -1052,35 +1180,19 @@ void Position::undoMove()
 	
 	if( m.isCastleMove() )
 	{
-		Color color = x.isBlackTurn() ? white : black;
-		eCastle cs = state::calcCastleRight(m.isKingSideCastle() ? castleOO: castleOOO, color);
-
-		tSquare rFrom = _castleRookInvolved[cs];
-		tSquare rTo = _castleRookFinalSquare[cs];
-		
-		tSquare kFrom = from;
-		tSquare kTo = _castleKingFinalSquare[cs];
-		
-		assert(rFrom < squareNumber);
-		assert(rTo < squareNumber);
-		assert(kFrom < squareNumber);
-		assert(kTo < squareNumber);
-		bitboardIndex rook = getPieceAt(rTo);
-		assert(isRook(rook));
-		
-		auto kPiece = getPieceAt(kTo);
-		removePiece(rook, rTo);
-		if( kFrom != kTo )
+		if( _isStandardCastling )
 		{
-			movePiece( kPiece, kTo, kFrom );
+			_undoCastle<c, true>( m );
+		}
+		else
+		{
+			_undoCastle<c, false>( m );
 		}
-		putPiece(rook, rFrom);
-		
 	}
 	else {
 		if( m.isPromotionMove() ){
 			removePiece(piece,to);
-			piece = isBlackPiece( piece) ? blackPawns : whitePawns;
+			piece = ourPawns;
 			putPiece(piece,to);
 		}
 		movePiece(piece, to, from);
@@ -1091,7 +1203,7 @@ void Position::undoMove()
 			tSquare capSq = to;
 			if( m.isEnPassantMove() )
 			{
-				capSq += pawnPush( x.isBlackTurn() );
+				capSq -= pawnPush( c );
 			}
 			assert( capSq < squareNumber );
 			putPiece( p, capSq );
@@ -1317,14 +1429,7 @@ inline void Position::calcCheckingSquares(void)
 	s.setCheckingSquares( getPieceOfPlayer( Knights, attackingPieces ), Movegen::attackFrom<whiteKnights>(kingSquare) );
 
 	s.setCheckingSquares( getPieceOfPlayer( Pawns, attackingPieces ), attackingPieces? Movegen::attackFrom<whitePawns>(kingSquare) : Movegen::attackFrom<blackPawns>(kingSquare) );
-
-	assert( getPieceOfOpponent( Pawns, attackingPieces ) >=0 );
-	s.resetCheckingSquares( getPieceOfOpponent( King,    attackingPieces ) );
-	s.resetCheckingSquares( getPieceOfOpponent( Rooks,   attackingPieces ) );
-	s.resetCheckingSquares( getPieceOfOpponent( Bishops, attackingPieces ) );
-	s.resetCheckingSquares( getPieceOfOpponent( Queens,  attackingPieces ) );
-	s.resetCheckingSquares( getPieceOfOpponent( Knights, attackingPieces ) );
-	s.resetCheckingSquares( getPieceOfOpponent( Pawns,   attackingPieces ) );
+	// the state stores only the checking squares of the player on move
 
 }
 
@@ -1491,17 +1596,17 @@ bool Position::hasRepeated(bool isPVline) const
 	const state &s = getActualState();
 	unsigned int counter = 1;
 	const HashKey& actualkey = s.getKey();
-	auto it = _stateInfo.rbegin();
+	const state* it = &s;
 	
 
 	int e = std::min( s.getIrreversibleMoveCount(), s.getPliesFromNullCount() );
 	if( e >= 4)
 	{
-		std::advance( it, 2 );
+		it -= 2;
 	}
 	for(int i = 4 ;	i<=e; i+=2 )
 	{
-		std::advance( it, 2 );
+		it -= 2;
 		if(it->getKey() == actualkey)
 		{
 			counter++;
@@ -1803,11 +1908,10 @@ bool Position::isMoveLegal(const Move &m)const
 
 Position::~Position() = default;
 
-Position::Position(const pawnHash usePawnHash):_ply(0), _mg(*this), _isChess960(false)
+Position::Position(const pawnHash usePawnHash):_ply(0), _mg(*this), _isChess960(false), _isStandardCastling(true)
 {
 	
-	_stateInfo.clear();
-	_stateInfo.emplace_back(state());
+	_stateInfo.reset();
 	_stateInfo[0].setNextTurn( whiteTurn );
 
 	updateUsThem();
@@ -1821,12 +1925,15 @@ Position::Position(const pawnHash usePawnHash):_ply(0), _mg(*this), _isChess960(
 	for (auto& sq : _castleRookFinalSquare) {sq = squareNone;}
 	
 	if (usePawnHash == pawnHash::on) {
-		_pawnHashTable = std::make_unique<pawnTable>();
+		_pawnHashTable = std::make_shared<pawnTable>();
+		_materialHashTable = std::make_shared<materialTable>();
+		_evalHashTable = std::make_shared<evalTable>();
 	}
+	resetNnueStack();
 }
 
 
-Position::Position(const Position& other, const pawnHash usePawnHash): _ply(other._ply), _mg(*this), _stateInfo(other._stateInfo), _squares(other._squares), _bitBoard(other._bitBoard), _isChess960(other._isChess960)
+Position::Position(const Position& other, const pawnHash usePawnHash): _ply(other._ply), _mg(*this), _stateInfo(other._stateInfo), _squares(other._squares), _bitBoard(other._bitBoard), _isChess960(other._isChess960), _isStandardCastling(other._isStandardCastling)
 {
 	
 	updateUsThem();
@@ -1838,8 +1945,11 @@ Position::Position(const Position& other, const pawnHash usePawnHash): _ply(othe
 	_castleRookFinalSquare = other._castleRookFinalSquare;
 	
 	if (usePawnHash == pawnHash::on) {
-		_pawnHashTable = std::make_unique<pawnTable>();
+		_pawnHashTable = std::make_shared<pawnTable>();
+		_materialHashTable = std::make_shared<materialTable>();
+		_evalHashTable = std::make_shared<evalTable>();
 	}
+	resetNnueStack();
 }
 
 
@@ -1850,12 +1960,39 @@ Position& Position::operator=(const Position& other)
 		return *this;
 	}
 
+	_stateInfo = other._stateInfo;
+	_copyBoard(other);
+
+	return *this;
+}
+
+void Position::copyWithRecentHistory(const Position& other)
+{
+	assert(this != &other);
+
+	// a repetition can only happen after the last irreversible or null move
+	const state& s = other.getActualState();
+	_stateInfo.copyTail( other._stateInfo, std::min( s.getIrreversibleMoveCount(), s.getPliesFromNullCount() ) + 1 );
+	_copyBoard(other);
+}
+
+void Position::shareHashTables(const Position& other)
+{
+	_pawnHashTable = other._pawnHashTable;
+	_materialHashTable = other._materialHashTable;
+	_evalHashTable = other._evalHashTable;
+}
+
+/*! \brief copy everything but the states from other
+*/
+void Position::_copyBoard(const Position& other)
+{
 	_ply = other._ply;
 
-	_stateInfo = other._stateInfo;
 	_squares = other._squares;
 	_bitBoard = other._bitBoard;
 	_isChess960 = other._isChess960;
+	_isStandardCastling = other._isStandardCastling;
 
 	updateUsThem();
 	
@@ -1866,7 +2003,12 @@ Position& Position::operator=(const Position& other)
 	_castleKingFinalSquare = other._castleKingFinalSquare;
 	_castleRookFinalSquare = other._castleRookFinalSquare;
 
-	return *this;
+	resetNnueStack();
+
+	// a new search always starts with an assignment, it's a good time to apply a new pawn hash size
+	if (_pawnHashTable) {
+		_pawnHashTable->updateSize();
+	}
 }
 
 inline void Position::updateUsThem()
@@ -1967,11 +2109,13 @@ std::string Position::_printEpSquare( const state& st)
 	\author Marco Belli
 	\version 1.0
 	\version 1.1 get rid of continuos malloc/free
+	\version 1.2 fixed capacity stack, the new state is a copy of the actual one
 	\date 21/11/2013
 */
-inline void Position::insertState( state & s )
+inline void Position::insertState()
 {
-	_stateInfo.emplace_back(s);
+	_stateInfo.push();
+	_stateInfo.back().copyPersistentData( _stateInfo.previous() );
 }
 
 /*! \brief  remove the last state
@@ -1982,16 +2126,58 @@ inline void Position::insertState( state & s )
 */
 inline void  Position::removeState()
 {
-	_stateInfo.pop_back();
+	_stateInfo.pop();
+}
+
+/*! \brief prepare the nnue accumulator of the state just inserted, to be computed from the previous one
+	the slots are never removed, so undoing a move doesn't need any nnue work
+*/
+inline nnueDirtyPieces& Position::insertNnueAccumulator()
+{
+	const unsigned int n = _stateInfo.size() - 1;
+	if( _nnueStack.size() <= n )
+	{
+		_nnueStack.resize( n + 1 );
+	}
+	nnueAccumulator& acc = _nnueStack[n];
+	acc.computed[white] = false;
+	acc.computed[black] = false;
+	acc.fromParent = true;
+	acc.dirty.count = 0;
+	return acc.dirty;
+}
+
+/*! \brief select the evaluation backend and invalidate all the nnue accumulators
+	it's called every time the position is set up, so a net loaded in the meanwhile is used from the next search
+*/
+void Position::resetNnueStack()
+{
+	const unsigned int id = Nnue::getInstance().getId();
+	if( id != _nnueId && _evalHashTable )
+	{
+		_evalHashTable->clear();
+	}
+	_nnueId = id;
+	_nnueStack.clear();
+	if( _nnueId )
+	{
+		// value initialized accumulators are not computed and can't be computed from the parent
+		_nnueStack.resize( _stateInfo.size() );
+	}
 }
 
 unsigned int Position::getNumberOfLegalMoves() const
 {
 	MoveList<MAX_MOVE_PER_POSITION> moveList;
-	_mg.generateMoves<Movegen::genType::allMg>( moveList );
+	getLegalMoves( moveList );
 	return moveList.size();
 }
 
+void Position::getLegalMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const
+{
+	_mg.generateMoves<Movegen::genType::allMg>( ml );
+}
+
 bitMap Position::_CastlePathOccupancyBitmap( const eCastle c ) const
 {
 	assert( c < 9);
@@ -28,16 +28,20 @@
 #include "data.h"
 #include "eCastle.h"
 #include "hashKey.h"
+#include "materialTable.h"
 #include "movegen.h"
 #include "move.h"
+#include "nnue.h"
 #include "score.h"
 #include "state.h"
+#include "stateStack.h"
 #include "vajolet.h"
 //---------------------------------------------------
 // forward declarations
 //---------------------------------------------------
 class pawnEntry;
 class pawnTable;
+class evalTable;
 
 //---------------------------------------------------
 //	class
@@ -73,6 +77,12 @@ public:
 	explicit Position(const Position& other, const pawnHash usePawnHash = pawnHash::on);
 	~Position();
 	Position& operator=(const Position& other);
+	/*! \brief copy the position keeping only the states needed to detect repetitions, used to start the helper threads
+	*/
+	void copyWithRecentHistory(const Position& other);
+	/*! \brief use the pawn, material and eval tables of other, used to evaluate many positions with the same tables
+	*/
+	void shareHashTables(const Position& other);
 	
 	
 	void setupCastleData (const eCastle cr, const tSquare kFrom, const tSquare kTo, const tSquare rFrom, const tSquare rTo);
@@ -129,12 +139,13 @@ public:
 	}
 	
 	unsigned int getNumberOfLegalMoves() const;
+	/*! \brief fill ml with the legal moves, checks, pins and en passant are handled by the generator so the moves don't need any further test
+	*/
+	void getLegalMoves( MoveList<MAX_MOVE_PER_POSITION>& ml ) const;
 	
 	void display(void) const;
 	std::string getFen(void) const;
-#ifdef DEBUG_EVAL_SIMMETRY
 	std::string getSymmetricFen() const;
-#endif
 
 	const Position& setupFromFen(const std::string& fenStr);
 	const Position& setup(const std::string& code, const Color c);
@@ -146,6 +157,9 @@ public:
 
 
 	template<bool trace>Score eval(void) const;
+	template<bool trace>Score eval(const Score alpha, const Score beta, bool& exact) const;
+	Score getStaticEval(void) const;
+	Score getStaticEval(const Score alpha, const Score beta, bool& exact) const;
 	bool isDraw(bool isPVline) const;
 	bool hasRepeated(bool isPVline = false) const;
 
@@ -326,6 +340,42 @@ public:
 	bitMap getCastleKingPath(const eCastle c ) const;
 	tSquare getCastleRookInvolved(const eCastle c ) const;
 
+	/*! \brief castle data, taken from the standard chess tables known at compile time or from the ones of the position
+	*/
+	template<bool standard> bool isCastlePathFree( const eCastle c ) const
+	{
+		assert( c < 9);
+		if constexpr (standard) { return !( _standardCastlePath[c] & getOccupationBitmap() ); }
+		else { return !( _castlePath[c] & getOccupationBitmap() ); }
+	}
+	template<bool standard> bitMap getCastleKingPath(const eCastle c ) const
+	{
+		assert( c < 9);
+		if constexpr (standard) { return _standardCastleKingPath[c]; }
+		else { return _castleKingPath[c]; }
+	}
+	template<bool standard> tSquare getCastleRookInvolved(const eCastle c ) const
+	{
+		assert( c < 9);
+		if constexpr (standard) { return _standardCastleRookInvolved[c]; }
+		else { return _castleRookInvolved[c]; }
+	}
+	template<bool standard> tSquare getCastleKingFinalSquare(const eCastle c ) const
+	{
+		assert( c < 9);
+		if constexpr (standard) { return _standardCastleKingFinalSquare[c]; }
+		else { return _castleKingFinalSquare[c]; }
+	}
+	template<bool standard> tSquare getCastleRookFinalSquare(const eCastle c ) const
+	{
+		assert( c < 9);
+		if constexpr (standard) { return _standardCastleRookFinalSquare[c]; }
+		else { return _castleRookFinalSquare[c]; }
+	}
+	/*! \brief true when king and rooks with castle rights are on the standard chess squares, also in a chess960 game
+	*/
+	bool hasStandardCastling() const {return _isStandardCastling;}
+
 	const Movegen& getMoveGen() const
 	{
 		return _mg;
@@ -350,25 +400,6 @@ private:
 	Position& operator=(Position&& ) noexcept = delete;
 	Position(Position&& ) noexcept = delete;
 
-	//--------------------------------------------------------
-	// private struct
-	//--------------------------------------------------------
-	struct materialStruct
-	{
-		using tType = enum class type
-		{
-			exact,
-			multiplicativeFunction,
-			exactFunction,
-			saturationH,
-			saturationL,
-		};
-		tType type;
-		bool (Position::*pointer)(Score &) const;
-		Score val;
-
-	};
-	
 	//--------------------------------------------------------
 	// private static members
 	//--------------------------------------------------------	
@@ -382,6 +413,13 @@ private:
 	static simdScore _pstValue[lastBitboard][squareNumber];
 	static simdScore _nonPawnValue[lastBitboard];
 	std::unordered_map<tKey, materialStruct> static _materialKeyMap;
+
+	// castle tables of standard chess, indexed by eCastle
+	static constexpr std::array<bitMap, 9> _standardCastlePath = { 0ull, 0x60ull, 0x0Eull, 0ull, 0x6000000000000000ull, 0ull, 0ull, 0ull, 0x0E00000000000000ull };
+	static constexpr std::array<bitMap, 9> _standardCastleKingPath = { 0ull, 0x70ull, 0x1Cull, 0ull, 0x7000000000000000ull, 0ull, 0ull, 0ull, 0x1C00000000000000ull };
+	static constexpr std::array<tSquare, 9> _standardCastleRookInvolved = { squareNone, H1, A1, squareNone, H8, squareNone, squareNone, squareNone, A8 };
+	static constexpr std::array<tSquare, 9> _standardCastleKingFinalSquare = { squareNone, G1, C1, squareNone, G8, squareNone, squareNone, squareNone, C8 };
+	static constexpr std::array<tSquare, 9> _standardCastleRookFinalSquare = { squareNone, F1, D1, squareNone, F8, squareNone, squareNone, squareNone, D8 };
 	
 	
 	//--------------------------------------------------------
@@ -400,9 +438,13 @@ private:
 
 
 	/*used for search*/
-	mutable std::unique_ptr<pawnTable> _pawnHashTable;
+	mutable std::shared_ptr<pawnTable> _pawnHashTable;
+	mutable std::shared_ptr<materialTable> _materialHashTable;
+	mutable std::shared_ptr<evalTable> _evalHashTable;
 
-	std::vector<state> _stateInfo;
+	StateStack<MAX_GAME_PLY + MAX_PLY> _stateInfo;
+	mutable std::vector<nnueAccumulator> _nnueStack;	/*!< nnue accumulators, indexed as _stateInfo. it's used only when _nnueId != 0*/
+	unsigned int _nnueId = 0;	/*!< id of the net used to evaluate the position, 0 for the classical evaluation*/
 
 	/*! \brief board rapresentation
 		\author Marco Belli
@@ -413,13 +455,24 @@ private:
 	std::array<bitMap,lastBitboard> _bitBoard;			// bitboards indexed by bitboardIndex enum
 	bitMap *Us,*Them;	/*!< pointer to our & their pieces _bitBoard*/
 	bool _isChess960;
+	bool _isStandardCastling;
 
 	//--------------------------------------------------------
 	// private methods
 	//--------------------------------------------------------
 
-	inline void insertState( state & s );
+	template<Color c> Score _see(const Move& m) const;
+	template<Color c> bool _seeCapture(const tSquare to, const bool canBePromotion, bitMap& occupied, bitMap& attackers, bitboardIndex& captured, Score * const swapList, unsigned int& slIndex) const;
+	template<Color c> void _doMove(const Move &m);
+	template<Color c> void _undoMove();
+	template<Color c, bool standard> void _doCastle(const Move &m, state& x, nnueDirtyPieces& dirty);
+	template<Color c, bool standard> void _undoCastle(const Move &m);
+
+	inline void insertState();
 	inline void removeState();
+	inline nnueDirtyPieces& insertNnueAccumulator();
+	void resetNnueStack();
+	void _copyBoard(const Position& other);
 
 	void updateUsThem();
 
@@ -449,9 +502,11 @@ private:
 	template<Color c> Score evalShieldStorm(tSquare ksq) const;
 	template<Color c> simdScore evalKingSafety(Score kingSafety, unsigned int kingAttackersCount, unsigned int kingAdjacentZoneAttacksCount, unsigned int kingAttackersWeight, bitMap * const attackedSquares) const;
 	
-	simdScore calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, bitMap * const attackedSquares , bitMap * const weakSquares, bitMap * const holes) const;
+	simdScore calcPawnValues(bitMap& weakPawns, bitMap& passedPawns, const bitMap * const holes) const;
+	void calcPawnMaps(bitMap * const attackedSquares , bitMap * const weakSquares, bitMap * const holes) const;
 
-	const materialStruct* getMaterialData() const;
+	const materialEntry& getMaterialData(materialEntry& localEntry) const;
+	void calcMaterialData(materialEntry& e) const;
 	bool evalKxvsK(Score& res) const;
 	bool evalKBPsvsK(Score& res) const;
 	bool evalKQvsKP(Score& res) const;
@@ -16,6 +16,7 @@
 */
 
 
+#include <chrono>
 #include <cmath>
 #include <mutex>
 #include <thread>
@@ -32,6 +33,7 @@
 #include "search.h"
 #include "searchData.h"
 #include "searchLogger.h"
+#include "searchStatistics.h"
 #include "searchTimer.h"
 #include "timeManagement.h"
 #include "thread.h"
@@ -71,7 +73,6 @@ public:
 	// public static methods
 	//--------------------------------------------------------
 	static void initSearchParameters(void);
-	static std::vector<impl> helperSearch;
 
 	//--------------------------------------------------------
 	// public methods
@@ -95,6 +96,7 @@ public:
 
 	unsigned long long getVisitedNodes() const;
 	unsigned long long getTbHits() const;
+	long long getStartLatency() const { return _startLatency; }
 	void showLine(){ _showLine= true;}
 	SearchResult manageNewSearch();
 	Position& getPosition();
@@ -141,6 +143,9 @@ private:
 	unsigned long long _visitedNodes = 0;
 	unsigned long long _tbHits = 0;
 	unsigned int _maxPlyReached = 0;
+	long long _startLatency = 0;	/*!< microseconds spent to start all the threads of the last search*/
+
+	std::vector<impl> _helperSearch;	/*!< lazy smp helpers, kept alive between searches*/
 
 	MultiPVManager _multiPVmanager;
 	Position _pos;
@@ -185,7 +190,7 @@ private:
 	void _showCurrenLine( const unsigned int ply, const int depth );
 	bool _MateDistancePruning( const unsigned int ply, Score& alpha, Score& beta) const;
 	void _appendTTmoveIfLegal(  const Move& ttm, PVline& pvLine ) const;
-	bool _canUseTTeValue( const bool PVnode, const Score beta, const Score ttValue, const ttEntry * const tte, short int depth ) const;
+	bool _canUseTTeValue( const bool PVnode, const Score beta, const Score ttValue, const ttEntry& tte, short int depth ) const;
 	const HashKey _getSearchKey( const bool excludedMove = false ) const;
 
 	using tableBaseRes = struct{ ttType TTtype; Score value;};
@@ -198,9 +203,6 @@ private:
 
 };
 
-std::vector<Search::impl> Search::impl::helperSearch;
-
-
 const int Search::impl::ONE_PLY;
 const int Search::impl::ONE_PLY_SHIFT;
 
@@ -302,7 +304,7 @@ Score Search::impl::nonPVreduction[2][LmrLimit*ONE_PLY][64];
 unsigned long long Search::impl::getVisitedNodes() const
 {
 	unsigned long long n = _visitedNodes;
-	for (auto& hs : helperSearch)
+	for (auto& hs : _helperSearch)
 		n += hs._visitedNodes;
 	return n;
 }
@@ -310,7 +312,7 @@ unsigned long long Search::impl::getVisitedNodes() const
 unsigned long long Search::impl::getTbHits() const
 {
 	unsigned long long n = _tbHits;
-	for (auto& hs : helperSearch)
+	for (auto& hs : _helperSearch)
 		n += hs._tbHits;
 	return n;
 }
@@ -364,9 +366,9 @@ void Search::impl::generateRootMovesList( std::vector<Move>& rm, const std::list
 	
 	if( ml.size() == 0 )	// all the legal moves
 	{
-		Move m;
-		MovePicker mp( _pos );
-		while( ( m = mp.getNextMove() ) )
+		MoveList<MAX_MOVE_PER_POSITION> legalMoves;
+		_pos.getLegalMoves( legalMoves );
+		for( auto& m: legalMoves )
 		{
 			rm.emplace_back( m );
 		}
@@ -618,6 +620,7 @@ void Search::impl::idLoop(std::vector<rootMove>& temporaryResults, unsigned int
 
 SearchResult Search::impl::go(int depth, Score alpha, Score beta, PVline pvToBeFollowed)
 {
+	const auto startTime = std::chrono::steady_clock::now();
 	//------------------------------------
 	//init the new search
 	//------------------------------------
@@ -644,16 +647,23 @@ SearchResult Search::impl::go(int depth, Score alpha, Score beta, PVline pvToBeF
 	// setup main thread
 	cleanMemoryBeforeStartingNewSearch();
 
-	// setup other threads
-	helperSearch.clear();
-	helperSearch.resize( uciParameters::threads - 1, *this );
+	// setup other threads, helpers are created only when the number of threads changes
+	if( _helperSearch.size() != uciParameters::threads - 1 )
+	{
+		_helperSearch.clear();
+		_helperSearch.resize( uciParameters::threads - 1, *this );
 
-	for (auto& hs : helperSearch)
+		for (auto& hs : _helperSearch)
+		{
+			// mute helper thread
+			hs.setUOI(UciOutput::create(UciOutput::type::mute));
+		}
+	}
+
+	for (auto& hs : _helperSearch)
 	{
-		// mute helper thread
-		hs.setUOI(UciOutput::create(UciOutput::type::mute));
-		
 		// setup helper thread
+		hs._rootMovesToBeSearched = _rootMovesToBeSearched;
 		hs.cleanMemoryBeforeStartingNewSearch();
 	}
 	
@@ -672,25 +682,29 @@ SearchResult Search::impl::go(int depth, Score alpha, Score beta, PVline pvToBeF
 	// multithread : lazy smp threads
 	//----------------------------
 
-	
-	std::vector<std::thread> helperThread;
+	my_thread &thr = my_thread::getInstance();
 	Move m(0);
 	rootMove rm(m);
 	std::vector<rootMove> helperResults( uciParameters::threads, rm);
 	std::vector<Move> toBeExcludedMove( uciParameters::threads, Move::NOMOVE);
 
-	// launch helper threads
+	// setup helper threads
 	for( unsigned int i = 1; i < ( uciParameters::threads); ++i)
 	{
-
 		helperResults[i].firstMove = m;
-		helperSearch[i-1].resetStopCondition();
-		helperSearch[i-1]._pos = _pos;
-		helperSearch[i-1]._pvLineFollower.setPVline(pvToBeFollowed);
-		helperSearch[i-1]._initialTurn = _initialTurn;
-		helperThread.emplace_back( std::thread(&Search::impl::idLoop, &helperSearch[i-1], std::ref(helperResults), i, std::ref(toBeExcludedMove), depth, alpha, beta, false));
+		_helperSearch[i-1].resetStopCondition();
+		_helperSearch[i-1]._pos.copyWithRecentHistory( _pos );
+		_helperSearch[i-1]._pvLineFollower.setPVline(pvToBeFollowed);
+		_helperSearch[i-1]._initialTurn = _initialTurn;
 	}
 
+	// wake up the parked helper threads
+	thr.startHelperThreads( uciParameters::threads - 1, [&](unsigned int i)
+	{
+		_helperSearch[i-1].idLoop(helperResults, i, toBeExcludedMove, depth, alpha, beta, false);
+	});
+	_startLatency = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - startTime ).count();
+
 	//----------------------------------
 	// iterative deepening loop
 	//----------------------------------
@@ -698,14 +712,11 @@ SearchResult Search::impl::go(int depth, Score alpha, Score beta, PVline pvToBeF
 	idLoop(helperResults, 0, toBeExcludedMove, depth, alpha, beta, true);
 	
 	// _stop helper threads
-	for(unsigned int i = 0; i< ( uciParameters::threads - 1); i++)
+	for(auto& hs : _helperSearch)
 	{
-		helperSearch[i].stopSearch();
-	}
-	for(auto &t : helperThread)
-	{
-		t.join();
+		hs.stopSearch();
 	}
+	thr.waitHelperThreads();
 	
 	//----------------------------------
 	// gather results
@@ -768,17 +779,17 @@ void Search::impl::_appendTTmoveIfLegal( const Move& ttm, PVline& pvLine ) const
 	}
 }
 
-inline bool Search::impl::_canUseTTeValue( const bool PVnode, const Score beta, const Score ttValue, const ttEntry * const tte, short int depth ) const
+inline bool Search::impl::_canUseTTeValue( const bool PVnode, const Score beta, const Score ttValue, const ttEntry& tte, short int depth ) const
 {
 	return
-		( tte->getDepth() >= depth )
+		( tte.getDepth() >= depth )
 		&& ( ttValue != SCORE_NONE )// Only in case of TT access race
 		&& (
 			PVnode ?
 				false :
 			ttValue >= beta ?
-				tte->isTypeGoodForBetaCutoff():
-				tte->isTypeGoodForAlphaCutoff()
+				tte.isTypeGoodForBetaCutoff():
+				tte.isTypeGoodForAlphaCutoff()
 		);
 }
 
@@ -932,16 +943,16 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 	//--------------------------------------
 	// test the transposition table
 	//--------------------------------------
-	ttEntry* tte = transpositionTable::getInstance().probe( posKey );
-	Move ttMove( tte->getPackedMove() );
-	Score ttValue = transpositionTable::scoreFromTT(tte->getValue(), ply);
+	ttEntry tte = transpositionTable::getInstance().probe( posKey );
+	Move ttMove( tte.getPackedMove() );
+	Score ttValue = transpositionTable::scoreFromTT(tte.getValue(), ply);
 
 	if (log) ln->test("CanUseTT");
 	if (	type != nodeType::ROOT_NODE
 			&& _canUseTTeValue( PVnode, beta, ttValue, tte, depth )
 		)
 	{
-		transpositionTable::getInstance().refresh(*tte);
+		transpositionTable::getInstance().refresh(posKey);
 		
 		if constexpr (PVnode)
 		{
@@ -957,6 +968,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 			_sd.saveKillers(ply, ttMove);
 			_updateCounterMove( ttMove );
 		}
+		searchStatistics::increment(searchStatistics::searchCutoffs);
 		if (log) ln->logReturnValue(ttValue);
 		if (log) ln->endSection();
 		return ttValue;
@@ -990,7 +1002,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 					res.TTtype,
 					std::min( 100 * ONE_PLY , depth + 6 * ONE_PLY),
 					ttMove,
-					_pos.eval<false>());
+					_pos.getStaticEval());
 				if (log) ln->logReturnValue(res.value);
 				if (log) ln->endSection();
 				return res.value;
@@ -1006,9 +1018,10 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 
 	Score staticEval;
 	Score eval;
-	if(inCheck || tte->getType() == typeVoid)
+	// pruning, improving and the TT need the exact static eval, the lazy one is left to the quiescence stand pat
+	if(inCheck || tte.getType() == typeVoid || tte.getStaticValue() == SCORE_NONE)
 	{
-		staticEval = _pos.eval<false>();
+		staticEval = _pos.getStaticEval();
 		eval = staticEval;
 		if (log) ln->calcStaticEval(staticEval);
 
@@ -1018,7 +1031,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 	}
 	else
 	{
-		staticEval = tte->getStaticValue();
+		staticEval = tte.getStaticValue();
 		eval = staticEval;
 		assert(staticEval < SCORE_INFINITE);
 		assert(staticEval > -SCORE_INFINITE);
@@ -1027,8 +1040,8 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 		if (ttValue != SCORE_NONE)
 		{
 			if (
-					( tte->isTypeGoodForBetaCutoff() && (ttValue > eval) )
-					|| (tte->isTypeGoodForAlphaCutoff() && (ttValue < eval) )
+					( tte.isTypeGoodForBetaCutoff() && (ttValue > eval) )
+					|| (tte.isTypeGoodForAlphaCutoff() && (ttValue < eval) )
 				)
 			{
 				if (log) ln->refineEval(ttValue);
@@ -1247,7 +1260,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 		_sd.setSkipNullMove(ply, skipBackup);
 
 		tte = transpositionTable::getInstance().probe(posKey);
-		ttMove = tte->getPackedMove();
+		ttMove = tte.getPackedMove();
 	}
 
 
@@ -1271,9 +1284,8 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::alphaBeta(un
 		&& depth >= (PVnode ? 6 * ONE_PLY : 8 * ONE_PLY)
 		&& ttMove
 		&& !excludedMove // Recursive singular Search is not allowed
-		&& tte != nullptr
-		&& tte->isTypeGoodForBetaCutoff()
-		&& tte->getDepth() >= depth - 3 * ONE_PLY;
+		&& tte.isTypeGoodForBetaCutoff()
+		&& tte.getDepth() >= depth - 3 * ONE_PLY;
 
 	while (bestScore <beta  && ( m = mp.getNextMove() ) )
 	{
@@ -1714,10 +1726,14 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 
 
 	const HashKey& posKey = _getSearchKey();
-	ttEntry* const tte = transpositionTable::getInstance().probe( _pos.getKey() );
-	if (log) ln->logTTprobe(*tte);
-	Move ttMove( tte->getPackedMove() );
+	const ttEntry tte = transpositionTable::getInstance().probe( _pos.getKey() );
+	if (log) ln->logTTprobe(tte);
+	Move ttMove( tte.getPackedMove() );
 	if(!_pos.isMoveLegal(ttMove)) {
+		if( ttMove )
+		{
+			searchStatistics::increment(searchStatistics::illegalTTMoves);
+		}
 		ttMove = Move::NOMOVE;
 	}
 	
@@ -1734,16 +1750,17 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 	MovePicker mp(_pos, _sd, ply, ttMove);
 	
 	short int TTdepth = mp.setupQuiescentSearch(inCheck, depth) * ONE_PLY;
-	Score ttValue = transpositionTable::scoreFromTT(tte->getValue(), ply);
+	Score ttValue = transpositionTable::scoreFromTT(tte.getValue(), ply);
 
 	if (log) ln->test("CanUseTT");
 	if( _canUseTTeValue( PVnode, beta, ttValue, tte, TTdepth ) )
 	{
-		transpositionTable::getInstance().refresh(*tte);
+		transpositionTable::getInstance().refresh(_pos.getKey());
 		if constexpr (PVnode)
 		{
 			_appendTTmoveIfLegal( ttMove, pvLine);
 		}
+		searchStatistics::increment(searchStatistics::qsearchCutoffs);
 		if (log) ln->logReturnValue(ttValue);
 		if (log) ln->endSection();
 		return ttValue;
@@ -1755,7 +1772,12 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 
 	if (log) ln->startSection("calc eval");
 
-	Score staticEval = (tte->getType() != typeVoid) ? tte->getStaticValue() : _pos.eval<false>();
+	// the lazy eval is only bounded by beta: an inexact score is always above it and it's only used for the stand pat cutoff
+	bool staticEvalExact = true;
+	Score staticEval = (tte.getType() != typeVoid && tte.getStaticValue() != SCORE_NONE) ? tte.getStaticValue()
+		: _pos.getStaticEval(-SCORE_INFINITE, ( uciParameters::lazyEval && !inCheck ) ? beta : SCORE_INFINITE, staticEvalExact);
+	// an inexact score is never stored as static value in the TT
+	const Score ttStaticEval = staticEvalExact ? staticEval : SCORE_NONE;
 	if (log) ln->calcStaticEval(staticEval);
 #ifdef DEBUG_EVAL_SIMMETRY
 	testSimmetry(_pos);
@@ -1768,14 +1790,15 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 	Score futilityBase;
 	if(!inCheck)
 	{
-		bestScore = staticEval;
+		// an inexact lazy eval only proves that the stand pat is above beta, only beta is returned and stored in the TT
+		bestScore = staticEvalExact ? staticEval : beta;
 		// todo trovare un valore buono per il futility
 
 		if( /*!PVnode && */ttValue != SCORE_NONE)
 		{
 			if (
-					( tte->isTypeGoodForBetaCutoff() && (ttValue > staticEval) )
-					|| (tte->isTypeGoodForAlphaCutoff() && (ttValue < staticEval) )
+					( tte.isTypeGoodForBetaCutoff() && (ttValue > staticEval) )
+					|| (tte.isTypeGoodForAlphaCutoff() && (ttValue < staticEval) )
 			)
 			{
 				bestScore = ttValue;
@@ -1802,7 +1825,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 				}
 				if(!_stop)
 				{
-					transpositionTable::getInstance().store(posKey, transpositionTable::scoreToTT(bestScore, ply), typeScoreHigherThanBeta,(short int)TTdepth, ttMove, staticEval);
+					transpositionTable::getInstance().store(posKey, transpositionTable::scoreToTT(bestScore, ply), typeScoreHigherThanBeta,(short int)TTdepth, ttMove, ttStaticEval);
 				}
 				if (log) ln->logReturnValue(bestScore);
 				if (log) ln->endSection();
@@ -1952,7 +1975,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 					}
 					if(!_stop)
 					{
-						transpositionTable::getInstance().store(posKey, transpositionTable::scoreToTT(bestScore, ply), typeScoreHigherThanBeta,(short int)TTdepth, bestMove, staticEval);
+						transpositionTable::getInstance().store(posKey, transpositionTable::scoreToTT(bestScore, ply), typeScoreHigherThanBeta,(short int)TTdepth, bestMove, ttStaticEval);
 					}
 					if (log) ln->logReturnValue(bestScore);
 					if (log) ln->endSection();
@@ -1979,7 +2002,7 @@ template<Search::impl::nodeType type, bool log> Score Search::impl::qsearch(unsi
 
 	if( !_stop )
 	{
-		transpositionTable::getInstance().store(posKey, transpositionTable::scoreToTT(bestScore, ply), TTtype, (short int)TTdepth, bestMove, staticEval);
+		transpositionTable::getInstance().store(posKey, transpositionTable::scoreToTT(bestScore, ply), TTtype, (short int)TTdepth, bestMove, ttStaticEval);
 	}
 	if (log) ln->logReturnValue(bestScore);
 	return bestScore;
@@ -2053,9 +2076,9 @@ Move Search::impl::_getPonderMoveFromHash(const Move& bestMove )
 	Move ponderMove(0);
 	_pos.doMove( bestMove );
 	
-	const ttEntry* const tte = transpositionTable::getInstance().probe(_pos.getKey());
+	const ttEntry tte = transpositionTable::getInstance().probe(_pos.getKey());
 	
-	Move m( tte->getPackedMove() );
+	Move m( tte.getPackedMove() );
 	if( _pos.isMoveLegal(m) )
 	{
 		ponderMove = m;
@@ -2212,6 +2235,7 @@ void Search::stopSearch(){ pimpl->stopSearch(); }
 void Search::resetStopCondition(){ pimpl->resetStopCondition(); }
 unsigned long long Search::getVisitedNodes() const{ return pimpl->getVisitedNodes(); }
 unsigned long long Search::getTbHits() const{ return pimpl->getTbHits(); }
+long long Search::getStartLatency() const{ return pimpl->getStartLatency(); }
 void Search::showLine(){ pimpl->showLine(); }
 SearchResult Search::manageNewSearch(){ return pimpl->manageNewSearch(); }
 Position& Search::getPosition(){ return pimpl->getPosition(); }
@@ -54,6 +54,7 @@ public:
 
 	unsigned long long getVisitedNodes() const;
 	unsigned long long getTbHits() const;
+	long long getStartLatency() const;
 	void showLine();
 	SearchResult manageNewSearch();
 	Position& getPosition();
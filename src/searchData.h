@@ -19,11 +19,12 @@
 
 #include "move.h"
 #include "history.h"
+#include "vajolet.h"
 
 class SearchData
 {
 private:
-	static const unsigned int STORY_LENGTH = 800;
+	static const unsigned int STORY_LENGTH = MAX_PLY;
 	
 	struct Sd
 	{
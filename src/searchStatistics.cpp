@@ -0,0 +1,118 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+#include "searchStatistics.h"
+
+/*! \brief list of the live thread counters, and the sum of the counters of the threads already terminated
+*/
+struct searchStatisticsRegistry
+{
+	std::mutex mutex;
+	std::vector<searchStatistics::threadCounters*> threads;
+	searchStatistics::values retired{};
+};
+
+static searchStatisticsRegistry& getRegistry()
+{
+	static searchStatisticsRegistry registry;
+	return registry;
+}
+
+searchStatistics::threadScope::threadScope()
+{
+	for( auto& c: _local )
+	{
+		c.store( 0, std::memory_order_relaxed );
+	}
+	auto& r = getRegistry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.threads.push_back( &_local );
+}
+
+searchStatistics::threadScope::~threadScope()
+{
+	auto& r = getRegistry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	for( unsigned int i = 0; i < countersNumber; ++i )
+	{
+		r.retired[i] += _local[i].load(std::memory_order_relaxed);
+	}
+	r.threads.erase( std::remove( r.threads.begin(), r.threads.end(), &_local ), r.threads.end() );
+}
+
+searchStatistics::values searchStatistics::get()
+{
+	auto& r = getRegistry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	values v = r.retired;
+	for( auto t: r.threads )
+	{
+		for( unsigned int i = 0; i < countersNumber; ++i )
+		{
+			v[i] += (*t)[i].load(std::memory_order_relaxed);
+		}
+	}
+	return v;
+}
+
+/*! \brief reset the counters, it shall be called when no search is running
+*/
+void searchStatistics::reset()
+{
+	auto& r = getRegistry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.retired.fill(0);
+	for( auto t: r.threads )
+	{
+		for( auto& c: *t )
+		{
+			c.store( 0, std::memory_order_relaxed );
+		}
+	}
+}
+
+static std::string percent( const uint64_t n, const uint64_t tot )
+{
+	std::ostringstream s;
+	s.precision(1);
+	s << std::fixed << ( tot ? 100.0 * n / tot : 0.0 ) << "%";
+	return s.str();
+}
+
+std::vector<std::string> searchStatistics::getReport()
+{
+	const values v = get();
+	const uint64_t hits = v[hitExact] + v[hitUpperBound] + v[hitLowerBound];
+	const uint64_t stores = v[storeEmpty] + v[storeSameKey] + v[storeReplace];
+	std::vector<std::string> report;
+
+	report.push_back( "tt probes " + std::to_string(v[probes]) + " hits " + std::to_string(hits) + " (" + percent(hits, v[probes]) + ")"
+		+ " exact " + std::to_string(v[hitExact]) + " upperbound " + std::to_string(v[hitUpperBound]) + " lowerbound " + std::to_string(v[hitLowerBound]) );
+	report.push_back( "tt stores " + std::to_string(stores) + " empty " + std::to_string(v[storeEmpty]) + " samekey " + std::to_string(v[storeSameKey])
+		+ " replaced " + std::to_string(v[storeReplace]) + " (" + percent(v[storeReplace], stores) + ")" );
+	report.push_back( "tt moves not legal " + std::to_string(v[illegalTTMoves]) + " (" + percent(v[illegalTTMoves], hits) + " of hits)" );
+	report.push_back( "tt cutoffs search " + std::to_string(v[searchCutoffs]) + " qsearch " + std::to_string(v[qsearchCutoffs]) );
+	report.push_back( "pawn hash probes " + std::to_string(v[pawnProbes]) + " hits " + std::to_string(v[pawnHits]) + " (" + percent(v[pawnHits], v[pawnProbes]) + ")" );
+	report.push_back( "material hash probes " + std::to_string(v[materialProbes]) + " hits " + std::to_string(v[materialHits]) + " (" + percent(v[materialHits], v[materialProbes]) + ")" );
+	report.push_back( "eval cache probes " + std::to_string(v[evalProbes]) + " hits " + std::to_string(v[evalHits]) + " (" + percent(v[evalHits], v[evalProbes]) + ")" );
+	report.push_back( "lazy eval probes " + std::to_string(v[lazyEvalProbes]) + " cutoffs " + std::to_string(v[lazyEvalCutoffs]) + " (" + percent(v[lazyEvalCutoffs], v[lazyEvalProbes]) + ")" );
+	return report;
+}
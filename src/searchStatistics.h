@@ -0,0 +1,87 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef SEARCH_STATISTICS_H_
+#define SEARCH_STATISTICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! \brief transposition table, hash tables and lazy eval counters
+	every thread owns a private set of counters, so counting doesn't cause contention.
+	the counters are a trivially constructible thread_local array, so an increment is a plain add without any initialization guard.
+	only the counters of the threads holding a threadScope are aggregated when they are read
+*/
+class searchStatistics
+{
+public:
+	enum counter
+	{
+		probes,
+		hitExact,
+		hitUpperBound,
+		hitLowerBound,
+		storeEmpty,
+		storeSameKey,
+		storeReplace,
+		illegalTTMoves,
+		searchCutoffs,
+		qsearchCutoffs,
+		pawnProbes,
+		pawnHits,
+		materialProbes,
+		materialHits,
+		evalProbes,
+		evalHits,
+		lazyEvalProbes,
+		lazyEvalCutoffs,
+		countersNumber
+	};
+
+	using values = std::array<uint64_t, countersNumber>;
+
+	using threadCounters = std::array<std::atomic<uint64_t>, countersNumber>;
+
+	/*! \brief the counters of the calling thread are reported while this object is alive
+		when it's destroyed they are added to the total of the terminated threads
+	*/
+	class threadScope
+	{
+	public:
+		explicit threadScope();
+		~threadScope();
+		threadScope(const threadScope&) = delete;
+		threadScope& operator=(const threadScope&) = delete;
+	};
+
+	static inline void increment(const counter c)
+	{
+		auto& v = _local[c];
+		v.store( v.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed );
+	}
+	static values get();
+	static void reset();
+	static std::vector<std::string> getReport();
+
+private:
+	// the definition is visible in every translation unit, so the compiler knows it needs no dynamic initialization
+	alignas(64) static inline thread_local threadCounters _local;
+};
+
+#endif /* SEARCH_STATISTICS_H_ */
@@ -32,26 +32,88 @@ Score Position::seeSign(const Move& m) const
 
 Score Position::see(const Move& m) const
 {
-
 	assert( m );
+	return isBlackPiece( getPieceAt( m.getFrom() ) ) ? _see<black>( m ) : _see<white>( m );
+}
+
+/*! \brief one capture of the exchange on the square to, done by the least valuable attacker of the player c
+	return false when the exchange is over
+*/
+template<Color c>
+inline bool Position::_seeCapture(const tSquare to, const bool canBePromotion, bitMap& occupied, bitMap& attackers, bitboardIndex& captured, Score * const swapList, unsigned int& slIndex) const
+{
+	constexpr bitboardIndex ourKing = c == white ? whiteKing : blackKing;
+	constexpr bitboardIndex theirPieces = c == white ? blackPieces : whitePieces;
+
+	assert(slIndex < 64);
+	// Add the new entry to the swap list
+	swapList[slIndex] = -swapList[slIndex - 1] + pieceValue[captured][0];
+
+	// Locate and remove the next least valuable attacker
+	bitboardIndex nextAttacker = (bitboardIndex)(Pawns);
+
+	while(nextAttacker >= King)
+	{
+		bitMap att = getBitmap(bitboardIndex(nextAttacker + ourKing - King)) & attackers;
+
+		if(att)
+		{
+			att= att & ~(att - 1); // find only one attacker
+			occupied ^= att;
+			attackers ^= att;
+
+			if (nextAttacker == Pawns || nextAttacker == Bishops || nextAttacker == Queens){
+				attackers |= Movegen::attackFrom<whiteBishops>(to,occupied) & (getBitmap(whiteBishops) | getBitmap(blackBishops) | getBitmap(whiteQueens) | getBitmap(blackQueens));
+			}
+
+			if (nextAttacker == Rooks || nextAttacker == Queens){
+				assert(to<squareNumber);
+				attackers |= Movegen::attackFrom<whiteRooks>(to,occupied) & (getBitmap(whiteRooks) | getBitmap(blackRooks) | getBitmap(whiteQueens) | getBitmap(blackQueens));
+			}
+			attackers &= occupied;
+			captured = nextAttacker;
+			if( nextAttacker == Pawns && canBePromotion)
+			{
+				swapList[slIndex] += pieceValue[whiteQueens][0] - pieceValue[whitePawns][0];
+				captured = whiteQueens;
+			}
+			break;
+		}
+		nextAttacker = bitboardIndex(nextAttacker - 1);
+	}
+	slIndex++;
+
+	const bitMap theirAttackers = attackers & getBitmap(theirPieces);
+
+	// Stop before processing a king capture
+	if (captured == King && theirAttackers)
+	{
+		swapList[slIndex++] = pieceValue[whiteKing][0];
+		return false;
+	}
+	return theirAttackers;
+}
+
+template<Color c>
+Score Position::_see(const Move& m) const
+{
+	constexpr Color them = c == white ? black : white;
+	constexpr bitboardIndex theirPieces = c == white ? blackPieces : whitePieces;
 
 	tSquare from = m.getFrom(), to = m.getTo();
 	const bool canBePromotion = getRankOf(to) == RANK1 ||  getRankOf(to) == RANK8;
 	bitMap occupied = getOccupationBitmap() ^ bitSet(from);
-	eNextMove color = isBlackPiece( getPieceAt(from) ) ? blackTurn : whiteTurn;
 
 	Score swapList[64];
 	unsigned int slIndex = 1;
-	bitMap colorAttackers;
 	bitboardIndex captured;
 
 	swapList[0] = pieceValue[getPieceAt(to)][0];
-	//std::cout<<"DEBUG inital capture: "<<swapList[0]<<std::endl;
 	captured = getPieceTypeAt(from);
 
 	if( m.isEnPassantMove() )
 	{
-		occupied ^= bitSet(to - pawnPush(color));
+		occupied ^= bitSet(to - pawnPush(c));
 		swapList[0] = pieceValue[whitePawns][0];
 	}
 	if( m.isCastleMove() )
@@ -66,15 +128,10 @@ Score Position::see(const Move& m) const
 
 	// Find all attackers to the destination square, with the moving piece
 	// removed, but possibly an X-ray attacker added behind it.
-	bitMap && attackers = getAttackersTo(to, occupied) & occupied;
+	bitMap attackers = getAttackersTo(to, occupied) & occupied;
 
 	// If the opponent has no attackers we are finished
-	color = (eNextMove)(blackTurn - color);
-	assert( (bitboardIndex)( Pieces + color ) == blackPieces || (bitboardIndex)( Pieces + color ) == whitePieces );
-	colorAttackers = attackers & getBitmap((bitboardIndex)(Pieces + color));
-
-
-	if (!colorAttackers)
+	if (!(attackers & getBitmap(theirPieces)))
 	{
 		return swapList[0];
 	}
@@ -86,73 +143,12 @@ Score Position::see(const Move& m) const
 	// destination square, where the sides alternately capture, and always
 	// capture with the least valuable piece. After each capture, we look for
 	// new X-ray attacks from behind the capturing piece.
-
-	//std::cout<<"DEBUG start the loop "<<swapList[0]<<std::endl;
+	// The loop is unrolled by two captures, so that the color of each one is a compile time constant.
 	assert( isValidPiece( captured ) );
 	assert(getPieceAt(from) != empty);
-	do
-	{
-		assert(slIndex < 64);
-		//std::cout<<"DEBUG iteration "<<slIndex<<std::endl;
-
-		// Add the new entry to the swap list
-		swapList[slIndex] = -swapList[slIndex - 1] + pieceValue[captured][0];
-		//std::cout<<"DEBUG capture piece "<<captured<<std::endl;
-		//std::cout<<"DEBUG capture value "<<pieceValue[captured][0]<<std::endl;
-		//std::cout<<"DEBUG new swaplist "<<swapList[slIndex]<<std::endl;
-
-
-		// Locate and remove the next least valuable attacker
-		bitboardIndex nextAttacker = (bitboardIndex)(Pawns);
-
-		while(nextAttacker >= King)
-		{
-			bitMap att = getBitmap(bitboardIndex(nextAttacker + color)) & colorAttackers;
-
-			if(att)
-			{
-				//std::cout<<"DEBUG attacking piece "<<nextAttacker<<std::endl;
-				//std::cout<<"DEBUG can be promotion "<<canBePromotion<<std::endl;
-				att= att & ~(att - 1); // find only one attacker
-				occupied ^= att;
-				attackers ^= att;
-
-				if (nextAttacker == Pawns || nextAttacker == Bishops || nextAttacker == Queens){
-					attackers |= Movegen::attackFrom<whiteBishops>(to,occupied) & (getBitmap(whiteBishops) | getBitmap(blackBishops) | getBitmap(whiteQueens) | getBitmap(blackQueens));
-				}
-
-				if (nextAttacker == Rooks || nextAttacker == Queens){
-					assert(to<squareNumber);
-					attackers |= Movegen::attackFrom<whiteRooks>(to,occupied) & (getBitmap(whiteRooks) | getBitmap(blackRooks) | getBitmap(whiteQueens) | getBitmap(blackQueens));
-				}
-				attackers &= occupied;
-				captured = nextAttacker;
-				if( nextAttacker == Pawns && canBePromotion)
-				{
-					//nextAttacker = Queens;
-					swapList[slIndex] += pieceValue[whiteQueens][0] - pieceValue[whitePawns][0];
-					//std::cout<<"DEBUG changed swaplist "<<swapList[slIndex]<<std::endl;
-					captured = whiteQueens;
-				}
-				break;
-			}
-			nextAttacker = bitboardIndex(nextAttacker - 1);
-		}
-		slIndex++;
-
-
-		color = (eNextMove)(blackTurn-color);
-		colorAttackers = attackers & getBitmap((bitboardIndex)(Pieces + color));
-
-		// Stop before processing a king capture
-		if (captured == King && colorAttackers)
-		{
-			swapList[slIndex++] = pieceValue[whiteKing][0];
-			//std::cout<<"DEBUG king capture, insert block "<<swapList[slIndex-1]<<std::endl;
-			break;
-		}
-
-	}while(colorAttackers);
+	while( _seeCapture<them>(to, canBePromotion, occupied, attackers, captured, swapList, slIndex)
+		&& _seeCapture<c>(to, canBePromotion, occupied, attackers, captured, swapList, slIndex) )
+	{}
 
 	// Having built the swap list, we negamax through it to find the best
 	// achievable score from the point of view of the side to move.
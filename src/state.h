@@ -37,165 +37,158 @@ class state
 public:
 	// todo modifiche a keys inseririle dentro alle altre chiamate
 	
-	// cppcheck-suppress uninitMemberVar symbolName=state::_castleRights
+	// cppcheck-suppress uninitMemberVar symbolName=state::_persistent
 	// cppcheck-suppress uninitMemberVar symbolName=state::_pinnedPieces
 	// cppcheck-suppress uninitMemberVar symbolName=state::_checkers
-	// cppcheck-suppress uninitMemberVar symbolName=state::_nextMove
 	// cppcheck-suppress uninitMemberVar symbolName=state::_hiddenCheckersCandidate
-	// cppcheck-suppress uninitMemberVar symbolName=state::_material
-	// cppcheck-suppress uninitMemberVar symbolName=state::_nonPawnMaterial
-	// cppcheck-suppress uninitMemberVar symbolName=state::_fiftyMoveCnt
-	// cppcheck-suppress uninitMemberVar symbolName=state::_pliesFromNull
 	// cppcheck-suppress uninitMemberVar symbolName=state::_checkingSquares
-	// cppcheck-suppress uninitMemberVar symbolName=state::_capturedPiece
-	// cppcheck-suppress uninitMemberVar symbolName=state::_epSquare
 	explicit state(){}
 
 	inline HashKey& getKey()
 	{
-		return _key;
+		return _persistent._key;
 	}
 
 	inline const HashKey& getKey() const
 	{
-		return _key;
+		return _persistent._key;
 	}
 
 	inline void setKey( const HashKey& k )
 	{
-		_key = k;
+		_persistent._key = k;
 	}
 
 	inline HashKey& getPawnKey()
 	{
-		return _pawnKey;
+		return _persistent._pawnKey;
 	}
 
 	inline const HashKey& getPawnKey() const
 	{
-		return _pawnKey;
+		return _persistent._pawnKey;
 	}
 
 	inline void setPawnKey( const HashKey& k )
 	{
-		_pawnKey = k;
+		_persistent._pawnKey = k;
 	}
 
 	inline HashKey& getMaterialKey()
 	{
-		return _materialKey;
+		return _persistent._materialKey;
 	}
 
 	inline const HashKey& getMaterialKey() const
 	{
-		return _materialKey;
+		return _persistent._materialKey;
 	}
 
 	inline void setMaterialKey( const HashKey& k )
 	{
-		_materialKey = k;
+		_persistent._materialKey = k;
 	}
 
 
 	inline bool hasEpSquare() const
 	{
-		return _epSquare != squareNone;
+		return _persistent._epSquare != squareNone;
 	}
 
 	inline bool isEpSquare( const tSquare s) const
 	{
-		return _epSquare == s;
+		return _persistent._epSquare == s;
 	}
 
 	inline tSquare getEpSquare() const
 	{
-		assert( _epSquare < squareNumber || _epSquare == squareNone);
-		return _epSquare;
+		assert( _persistent._epSquare < squareNumber || _persistent._epSquare == squareNone);
+		return _persistent._epSquare;
 	}
 
 	inline void resetEpSquare()
 	{
-		_epSquare = squareNone;
+		_persistent._epSquare = squareNone;
 	}
 
 	inline void setEpSquare( const tSquare s )
 	{
-		_epSquare = s;
+		_persistent._epSquare = s;
 	}
 
 	inline unsigned int getPliesFromNullCount() const
 	{
-		return _pliesFromNull;
+		return _persistent._pliesFromNull;
 	}
 	inline void resetPliesFromNullCount()
 	{
-		_pliesFromNull = 0;
+		_persistent._pliesFromNull = 0;
 	}
 
 	inline void incrementPliesFromNullCount()
 	{
-		++_pliesFromNull;
+		++_persistent._pliesFromNull;
 	}
 
 	inline unsigned int getIrreversibleMoveCount() const
 	{
-		return _fiftyMoveCnt;
+		return _persistent._fiftyMoveCnt;
 	}
 
 	inline void setIrreversibleMoveCount(unsigned int x)
 	{
-		_fiftyMoveCnt = x;
+		_persistent._fiftyMoveCnt = x;
 	}
 
 	inline void resetIrreversibleMoveCount()
 	{
-		_fiftyMoveCnt = 0;
+		_persistent._fiftyMoveCnt = 0;
 	}
 
 	inline void incrementIrreversibleMoveCount()
 	{
-		++_fiftyMoveCnt;
+		++_persistent._fiftyMoveCnt;
 	}
 
 	inline simdScore getNonPawnValue() const
 	{
-		return _nonPawnMaterial;
+		return _persistent._nonPawnMaterial;
 	}
 
 	inline void setNonPawnValue( const simdScore& sc)
 	{
-		_nonPawnMaterial = sc;
+		_persistent._nonPawnMaterial = sc;
 	}
 
 	inline void addNonPawnMaterial( const simdScore& sc)
 	{
-		_nonPawnMaterial += sc;
+		_persistent._nonPawnMaterial += sc;
 	}
 
 	inline void removeNonPawnMaterial( const simdScore& sc)
 	{
-		_nonPawnMaterial -= sc;
+		_persistent._nonPawnMaterial -= sc;
 	}
 
 
 	inline simdScore getMaterialValue() const
 	{
-		return _material;
+		return _persistent._material;
 	}
 
 	inline void setMaterialValue( const simdScore& sc)
 	{
-		_material = sc;
+		_persistent._material = sc;
 	}
 
 	inline void addMaterial( const simdScore& sc)
 	{
-		_material += sc;
+		_persistent._material += sc;
 	}
 
 	inline void removeMaterial( const simdScore& sc)
 	{
-		_material -= sc;
+		_persistent._material -= sc;
 	}
 
 	static inline eCastle calcCastleRight( const eCastle cr, const Color c )
@@ -205,47 +198,47 @@ public:
 
 	inline bool hasCastleRight( const eCastle cr )const
 	{
-		return _castleRights & cr;
+		return _persistent._castleRights & cr;
 	};
 
 	inline bool hasCastleRight( const eCastle cr, const Color c )const
 	{
-		return _castleRights & calcCastleRight( cr, c );
+		return _persistent._castleRights & calcCastleRight( cr, c );
 	};
 
 	inline const eCastle& getCastleRights() const
 	{
-		return _castleRights;
+		return _persistent._castleRights;
 	}
 
 	inline bool hasCastleRights() const
 	{
-		return _castleRights;
+		return _persistent._castleRights;
 	}
 
 	inline void clearCastleRight()
 	{
-		_castleRights = (eCastle)0;
+		_persistent._castleRights = (eCastle)0;
 	}
 
 	inline void clearCastleRight( const eCastle c )
 	{
-		_castleRights = (eCastle)(_castleRights & ( ~c ) );
+		_persistent._castleRights = (eCastle)(_persistent._castleRights & ( ~c ) );
 	}
 
 	inline void setCastleRight( const eCastle c )
 	{
-		_castleRights = (eCastle)( _castleRights | c );
+		_persistent._castleRights = (eCastle)( _persistent._castleRights | c );
 	}
 
 	inline const Move& getCurrentMove() const
 	{
-		return _currentMove;
+		return _persistent._currentMove;
 	}
 
 	inline void setCurrentMove( const Move & m )
 	{
-		_currentMove = m;
+		_persistent._currentMove = m;
 	}
 
 	inline bool isInCheck() const
@@ -285,47 +278,47 @@ public:
 
 	inline void setNextTurn( const eNextMove nm )
 	{
-		_nextMove = nm;
+		_persistent._nextMove = nm;
 	}
 
 	inline eNextMove getNextTurn() const
 	{
-		return _nextMove;
+		return _persistent._nextMove;
 	}
 
 	inline bitboardIndex getPiecesOfActivePlayer() const
 	{
-		return (bitboardIndex)(whitePieces + _nextMove);
+		return (bitboardIndex)(whitePieces + _persistent._nextMove);
 	}
 
 	inline bitboardIndex getPiecesOfOtherPlayer() const
 	{
-		return (bitboardIndex)(blackPieces - _nextMove);
+		return (bitboardIndex)(blackPieces - _persistent._nextMove);
 	}
 
 	inline bitboardIndex getKingOfActivePlayer() const
 	{
-		return (bitboardIndex)(whiteKing + _nextMove);
+		return (bitboardIndex)(whiteKing + _persistent._nextMove);
 	}
 
 	inline bitboardIndex getKingOfOtherPlayer() const
 	{
-		return (bitboardIndex)(blackKing - _nextMove);
+		return (bitboardIndex)(blackKing - _persistent._nextMove);
 	}
 
 	inline bitboardIndex getPawnsOfActivePlayer() const
 	{
-		return (bitboardIndex)(whitePawns + _nextMove);
+		return (bitboardIndex)(whitePawns + _persistent._nextMove);
 	}
 
 	inline bitboardIndex getPawnsOfOtherPlayer() const
 	{
-		return (bitboardIndex)(blackPawns - _nextMove);
+		return (bitboardIndex)(blackPawns - _persistent._nextMove);
 	}
 
 	inline bool isBlackTurn() const
 	{
-		return _nextMove;
+		return _persistent._nextMove;
 	}
 
 	inline bool isWhiteTurn() const
@@ -335,12 +328,12 @@ public:
 
 	inline void changeNextTurn()
 	{
-		_nextMove = getSwitchedTurn();
+		_persistent._nextMove = getSwitchedTurn();
 	}
 
 	inline eNextMove getSwitchedTurn() const
 	{
-		return (eNextMove)( blackTurn - _nextMove );
+		return (eNextMove)( blackTurn - _persistent._nextMove );
 	}
 
 	inline bool thereAreHiddenCheckers() const
@@ -364,52 +357,72 @@ public:
 	
 	inline void setCheckingSquares( const bitboardIndex piece, const bitMap & b )
 	{
-		_checkingSquares[ piece ] = b;
+		assert( ( piece & separationBitmap ) == (int)_persistent._nextMove );
+		_checkingSquares[ piece & ~separationBitmap ] = b;
 	}
 	
 	inline void resetCheckingSquares( const bitboardIndex piece )
 	{
-		_checkingSquares[ piece ] = 0;
+		assert( ( piece & separationBitmap ) == (int)_persistent._nextMove );
+		_checkingSquares[ piece & ~separationBitmap ] = 0;
 	}
 	
 	inline const bitMap& getCheckingSquares( const bitboardIndex piece ) const
 	{
-		return _checkingSquares[ piece ];
+		assert( ( piece & separationBitmap ) == (int)_persistent._nextMove );
+		return _checkingSquares[ piece & ~separationBitmap ];
 	}
 	
 	inline const bitboardIndex& getCapturedPiece() const
 	{
-		return _capturedPiece;
+		return _persistent._capturedPiece;
 	}
 	
 	inline void setCapturedPiece( const bitboardIndex p )
 	{
-		_capturedPiece = p;
+		_persistent._capturedPiece = p;
 	}
 	
 	inline void resetCapturedPiece()
 	{
-		_capturedPiece = empty;
+		_persistent._capturedPiece = empty;
+	}
+
+	/*! \brief copy the part of the state that is inherited by the next ply
+	*/
+	inline void copyPersistentData( const state& s )
+	{
+		_persistent = s._persistent;
 	}
 
 private:
-	eCastle _castleRights; /*!<  actual castle rights*/
-	Move _currentMove;
-	bitMap _pinnedPieces;	/*!< pinned pieces*/
+	/*! \brief data inherited from the previous ply and updated incrementally by doMove, it's the only part copied for every move
+	*/
+	struct persistentData
+	{
+		simdScore _material;
+		simdScore _nonPawnMaterial; /*!< four score used for white/black opening/endgame non pawn material sum*/
+		HashKey _key,		/*!<  hashkey identifying the position*/
+				_pawnKey,	/*!<  hashkey identifying the pawn formation*/
+				_materialKey;/*!<  hashkey identifying the material signature*/
+		eCastle _castleRights; /*!<  actual castle rights*/
+		eNextMove _nextMove; /*!< who is the active player*/
+		unsigned short _fiftyMoveCnt;	/*!<  50 move count used for draw rule*/
+		unsigned short _pliesFromNull;	/*!<  plies from null move*/
+		bitboardIndex _capturedPiece; /*!<  index of the captured piece for unmakeMove*/
+		tSquare _epSquare;	/*!<  en passant square*/
+		Move _currentMove;
+	} _persistent;
+
+	// data recomputed from the board after every move, it's never copied
 	bitMap _checkers;	/*!< checking pieces*/
-	eNextMove _nextMove; /*!< who is the active player*/
+	bitMap _pinnedPieces;	/*!< pinned pieces*/
 	bitMap _hiddenCheckersCandidate;	/*!< pieces who can make a discover check moving*/
-	simdScore _material;
-	simdScore _nonPawnMaterial; /*!< four score used for white/black opening/endgame non pawn material sum*/
-	unsigned int _fiftyMoveCnt;	/*!<  50 move count used for draw rule*/
-	unsigned int _pliesFromNull;	/*!<  plies from null move*/
-	bitMap _checkingSquares[lastBitboard]; /*!< squares of the board from where a king can be checked*/
-	bitboardIndex _capturedPiece; /*!<  index of the captured piece for unmakeMove*/
-	tSquare _epSquare;	/*!<  en passant square*/
-	HashKey _key,		/*!<  hashkey identifying the position*/
-			_pawnKey,	/*!<  hashkey identifying the pawn formation*/
-			_materialKey;/*!<  hashkey identifying the material signature*/
+	bitMap _checkingSquares[separationBitmap]; /*!< squares of the board from where a king can be checked, indexed by the piece type of the player on move*/
 
+	static_assert( sizeof(persistentData) <= 80, "the persistent data are copied for every move" );
 };
 
+static_assert( sizeof(state) <= 176, "a state is stored for every ply of the game and of the search" );
+
 #endif
@@ -0,0 +1,150 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#ifndef STATESTACK_H_
+#define STATESTACK_H_
+
+#include <algorithm>
+#include <memory>
+
+#include "state.h"
+#include "vajolet.h"
+
+/*! \brief stack of the position states, the storage is allocated once with capacity N and never grows
+	push and pop don't check the capacity, the caller must never go over N states
+*/
+template <std::size_t N> class StateStack
+{
+
+public:
+
+/*****************************************************************
+*	constructors
+******************************************************************/
+	explicit StateStack(): _states(new state[N]), _last(_states.get()) {}
+	StateStack(const StateStack& other): StateStack() { *this = other; }
+	StateStack& operator=(const StateStack& other);
+
+/*****************************************************************
+*	methods
+******************************************************************/
+	void reset( void );
+	void push( void );
+	void pop( void );
+	unsigned int size() const;
+	state& back();
+	const state& back() const;
+	const state& previous() const;
+	const state& operator[]( const unsigned int n ) const;
+	state& operator[]( const unsigned int n );
+	void copyTail( const StateStack& other, const unsigned int n );
+
+/*****************************************************************
+*	members
+******************************************************************/
+private:
+	std::unique_ptr<state[]> _states;
+	state* _last;	// top of the stack, the stack is never empty
+};
+
+template <std::size_t N>
+inline StateStack<N>& StateStack<N>::operator=( const StateStack& other )
+{
+	if( this != &other )
+	{
+		copyTail( other, other.size() );
+	}
+	return *this;
+}
+
+/*! \brief empty the stack leaving only the bottom state, its content has to be set up by the caller
+*/
+template <std::size_t N>
+inline void StateStack<N>::reset( void )
+{
+	_last = _states.get();
+}
+
+/*! \brief push a new state, its content is not initialized
+*/
+template <std::size_t N>
+inline void StateStack<N>::push( void )
+{
+	assert( size() < N );
+	++_last;
+}
+
+template <std::size_t N>
+inline void StateStack<N>::pop( void )
+{
+	assert( size() > 1 );
+	--_last;
+}
+
+template <std::size_t N>
+inline unsigned int StateStack<N>::size() const
+{
+	return _last - _states.get() + 1;
+}
+
+template <std::size_t N>
+inline state& StateStack<N>::back()
+{
+	return *_last;
+}
+
+template <std::size_t N>
+inline const state& StateStack<N>::back() const
+{
+	return *_last;
+}
+
+/*! \brief the state below the top one
+*/
+template <std::size_t N>
+inline const state& StateStack<N>::previous() const
+{
+	assert( size() > 1 );
+	return _last[-1];
+}
+
+template <std::size_t N>
+inline const state& StateStack<N>::operator[]( const unsigned int n ) const
+{
+	assert( n < size() );
+	return _states[n];
+}
+
+template <std::size_t N>
+inline state& StateStack<N>::operator[]( const unsigned int n )
+{
+	assert( n < size() );
+	return _states[n];
+}
+
+/*! \brief replace the content of the stack with the last n states of other
+*/
+template <std::size_t N>
+inline void StateStack<N>::copyTail( const StateStack& other, const unsigned int n )
+{
+	const unsigned int count = std::min( std::max( n, 1u ), other.size() );
+	const state* last = other._last + 1;
+	std::copy( last - count, last, _states.get() );
+	_last = _states.get() + ( count - 1 );
+}
+
+#endif /* STATESTACK_H_ */
@@ -18,12 +18,14 @@
 #include <condition_variable>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 #include "vajo_io.h"
 #include "position.h"
 #include "search.h"
 #include "searchLimits.h"
 #include "searchResult.h"
+#include "searchStatistics.h"
 #include "searchTimer.h"
 #include "timeManagement.h"
 #include "thread.h"
@@ -59,6 +61,16 @@ private:
 	std::condition_variable _searchCond;
 	std::condition_variable _timerCond;
 	
+	// lazy smp helper threads, they are created once and parked between searches
+	std::vector<std::thread> _helpers;
+	std::mutex _hMutex;
+	std::condition_variable _helperCond;
+	std::condition_variable _helperDoneCond;
+	std::function<void(unsigned int)> _helperJob;
+	unsigned long long _helperJobId = 0;
+	unsigned int _helperJobSize = 0;
+	unsigned int _runningHelpers = 0;
+	
 	volatile static bool _quit;
 	volatile static bool _startThink;
 	
@@ -76,6 +88,7 @@ private:
 	
 	void _timerThread();
 	void _searchThread();
+	void _helperThread( const unsigned int index );
 	void _printTimeDependentOutput( long long int time );
 	void _stopPonder();
 
@@ -86,6 +99,8 @@ public:
 	void stopThinking();
 	void ponderHit();
 	timeManagement& getTimeMan();
+	void startHelperThreads( const unsigned int n, std::function<void(unsigned int)> job );
+	void waitHelperThreads();
 };
 
 volatile bool my_thread::impl::_quit = false;
@@ -158,6 +173,7 @@ void my_thread::impl::_timerThread()
 
 void my_thread::impl::_searchThread()
 {
+	searchStatistics::threadScope statisticsScope;
 	std::unique_lock<std::mutex> lk(_sMutex);
 	
 	while (!_quit)
@@ -184,6 +200,59 @@ void my_thread::impl::_searchThread()
 	}
 }
 
+void my_thread::impl::_helperThread( const unsigned int index )
+{
+	searchStatistics::threadScope statisticsScope;
+	unsigned long long lastJobId = 0;
+	std::unique_lock<std::mutex> lk(_hMutex);
+	
+	while (true)
+	{
+		_helperCond.wait(lk, [&]{ return _quit || ( _helperJobId != lastJobId && index <= _helperJobSize ); } );
+		
+		// pending jobs are completed before quitting, the master is waiting for them
+		if( _helperJobId == lastJobId || index > _helperJobSize )
+		{
+			return;
+		}
+		lastJobId = _helperJobId;
+		
+		lk.unlock();
+		_helperJob(index);
+		lk.lock();
+		
+		if( --_runningHelpers == 0 )
+		{
+			_helperDoneCond.notify_all();
+		}
+	}
+}
+
+inline void my_thread::impl::startHelperThreads( const unsigned int n, std::function<void(unsigned int)> job )
+{
+	std::unique_lock<std::mutex> lk(_hMutex);
+	
+	// helper threads are only created the first time they are needed
+	while( _helpers.size() < n )
+	{
+		_helpers.emplace_back( &my_thread::impl::_helperThread, this, _helpers.size() + 1 );
+	}
+	
+	_helperJob = std::move(job);
+	_helperJobSize = n;
+	_runningHelpers = n;
+	++_helperJobId;
+	
+	lk.unlock();
+	_helperCond.notify_all();
+}
+
+inline void my_thread::impl::waitHelperThreads()
+{
+	std::unique_lock<std::mutex> lk(_hMutex);
+	_helperDoneCond.wait(lk, [&]{ return _runningHelpers == 0; } );
+}
+
 bool my_thread::impl::_initThreads()
 {
 	std::lock( _tMutex, _sMutex );
@@ -202,17 +271,25 @@ bool my_thread::impl::_initThreads()
 
 inline void my_thread::impl::_quitThreads()
 {
-	std::lock( _tMutex, _sMutex );
+	std::lock( _tMutex, _sMutex, _hMutex );
 	std::unique_lock<std::mutex> lks(_sMutex, std::adopt_lock);
 	std::unique_lock<std::mutex> lkt(_tMutex, std::adopt_lock);
+	std::unique_lock<std::mutex> lkh(_hMutex, std::adopt_lock);
 	_quit = true;
 	lks.unlock();
 	lkt.unlock();
+	lkh.unlock();
 
 	_searchCond.notify_one();
 	_timerCond.notify_one();
 	_timer.join();
 	_searcher.join();
+	
+	_helperCond.notify_all();
+	for( auto& h: _helpers )
+	{
+		h.join();
+	}
 }
 
 inline void my_thread::impl::startThinking( const Position& p, SearchLimits& l)
@@ -263,3 +340,7 @@ void my_thread::ponderHit() { pimpl->ponderHit();}
 timeManagement& my_thread::getTimeMan(){ return pimpl->getTimeMan(); }
 
 void my_thread::startThinking( const Position& p, SearchLimits& l){	pimpl->startThinking( p, l); }
+
+void my_thread::startHelperThreads( const unsigned int n, std::function<void(unsigned int)> job ){ pimpl->startHelperThreads( n, std::move(job) ); }
+
+void my_thread::waitHelperThreads(){ pimpl->waitHelperThreads(); }
@@ -18,6 +18,9 @@
 #ifndef THREAD_H_
 #define THREAD_H_
 
+#include <functional>
+#include <memory>
+
 class Position;
 class timeManagement;
 class SearchLimits;
@@ -46,5 +49,7 @@ public :
 	void stopThinking();
 	void ponderHit();
 	timeManagement& getTimeMan();
+	void startHelperThreads( const unsigned int n, std::function<void(unsigned int)> job );
+	void waitHelperThreads();
 };
 #endif /* THREAD_H_ */
@@ -15,72 +15,324 @@
     along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
 */
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#endif
 
 #include "hashKey.h"
 #include "move.h"
+#include "searchStatistics.h"
 #include "transposition.h"
+#include "uciParameters.h"
 #include "vajolet.h"
 
 
-inline void ttEntry::save(unsigned int Key, Score Value, unsigned char Type, signed short int Depth, unsigned short Move, Score StaticValue, unsigned char gen)
+/*! \brief header of the files created by saveToFile
+	the clusters start at a page boundary so that the file can be mapped directly
+*/
+struct ttFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t clusterSize;
+	uint64_t elements;
+	uint8_t generation;
+};
+
+static const char ttFileMagic[8] = { 'V', 'A', 'J', 'O', 'L', 'E', 'T', 'T' };
+static const uint32_t ttFileVersion = 2;
+static const size_t ttFileHeaderSize = 4096;
+
+transpositionTable::~transpositionTable()
+{
+	_free();
+}
+
+#ifdef __linux__
+static ttCluster* allocateWithMmap(unsigned long long int bytes, int flags)
+{
+	void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+	return mem == MAP_FAILED ? nullptr : static_cast<ttCluster*>(mem);
+}
+#endif
+
+void transpositionTable::_allocate(unsigned long long int bytes)
+{
+	_table = nullptr;
+	_memoryType = memoryType::normalPages;
+
+#ifdef __linux__
+	if( _largePages )
+	{
+		// explicit huge pages need a reserved pool (vm.nr_hugepages), and the size shall be a multiple of the page size
+		if( bytes % (1ull << 30) == 0 && ( _table = allocateWithMmap(bytes, MAP_HUGETLB | MAP_HUGE_1GB) ) )
+		{
+			_memoryType = memoryType::hugePages1GB;
+		}
+		else if( bytes % (1ull << 21) == 0 && ( _table = allocateWithMmap(bytes, MAP_HUGETLB | MAP_HUGE_2MB) ) )
+		{
+			_memoryType = memoryType::hugePages2MB;
+		}
+		else if( bytes % (1ull << 21) == 0 && ( _table = allocateWithMmap(bytes, 0) ) )
+		{
+			// ask for transparent huge pages, an error here isn't fatal: the memory is simply backed by normal pages
+			if( madvise(_table, bytes, MADV_HUGEPAGE) == 0 )
+			{
+				_memoryType = memoryType::transparentHugePages;
+			}
+			else
+			{
+				munmap(_table, bytes);
+				_table = nullptr;
+			}
+		}
+	}
+#endif
+
+	if( !_table )
+	{
+		_table = static_cast<ttCluster*>( ::operator new[]( bytes, std::align_val_t(alignof(ttCluster)), std::nothrow ) );
+		if( !_table )
+		{
+			std::cerr << "Failed to allocate " << (bytes >> 20) << "MB for transposition table." << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// the first touch of the pages is done by several threads, it's faster and on NUMA machines spread the table over the nodes
+	_forEachChunk( []( ttCluster* begin, ttCluster* end ){ std::uninitialized_default_construct( begin, end ); } );
+}
+
+void transpositionTable::_forEachChunk( void (*job)( ttCluster* begin, ttCluster* end ) )
+{
+	// don't bother starting threads for small tables
+	static const unsigned long int minChunkSize = 1ul << 16;
+	const unsigned long int workers = std::max( 1ul, std::min( (unsigned long int)uciParameters::threads, _elements / minChunkSize ) );
+	const unsigned long int chunkSize = ( _elements + workers - 1 ) / workers;
+
+	std::vector<std::thread> threads;
+	for( unsigned long int i = 1; i < workers; ++i )
+	{
+		ttCluster* begin = _table + std::min( _elements, i * chunkSize );
+		ttCluster* end = _table + std::min( _elements, ( i + 1 ) * chunkSize );
+		threads.emplace_back( job, begin, end );
+	}
+	job( _table, _table + std::min( _elements, chunkSize ) );
+
+	for( auto& t: threads )
+	{
+		t.join();
+	}
+}
+
+void transpositionTable::_free()
 {
-	key = Key;
-	value = Value;
-	staticValue = StaticValue;
-	if(Move)
+	if( !_table )
 	{
-		packedMove = Move;
+		return;
 	}
-	depth = Depth;
-	generation = gen;
-	type = Type;
+	if( _memoryType == memoryType::normalPages )
+	{
+		::operator delete[]( _table, std::align_val_t(alignof(ttCluster)) );
+	}
+#ifdef __linux__
+	else if( _memoryType == memoryType::mappedFile )
+	{
+		munmap( reinterpret_cast<char*>(_table) - ttFileHeaderSize, ttFileHeaderSize + _elements * sizeof(ttCluster) );
+	}
+	else
+	{
+		munmap(_table, _elements * sizeof(ttCluster));
+	}
+#endif
+	_table = nullptr;
 }
 
-inline void ttEntry::setGeneration(unsigned char gen)
+bool transpositionTable::saveToFile(const std::string& path) const
 {
-	generation = gen;
+	if( !_table )
+	{
+		return false;
+	}
+
+	std::ofstream f( path, std::ios::binary | std::ios::trunc );
+	if( !f )
+	{
+		return false;
+	}
+
+	std::array<char, ttFileHeaderSize> header{};
+	// value initialized, the padding bytes written to the file are zero
+	ttFileHeader h{};
+	std::memcpy( h.magic, ttFileMagic, sizeof(h.magic) );
+	h.version = ttFileVersion;
+	h.clusterSize = sizeof(ttCluster);
+	h.elements = _elements;
+	h.generation = _generation;
+	std::memcpy( header.data(), &h, sizeof(h) );
+
+	f.write( header.data(), header.size() );
+	// write the clusters straight from the table, without any intermediate copy
+	f.write( reinterpret_cast<const char*>(_table), (std::streamsize)( _elements * sizeof(ttCluster) ) );
+	return (bool)f;
 }
 
+bool transpositionTable::loadFromFile(const std::string& path)
+{
+	ttFileHeader h{};
+	{
+		std::ifstream f( path, std::ios::binary );
+		if( !f.read( reinterpret_cast<char*>(&h), sizeof(h) ) )
+		{
+			return false;
+		}
+	}
+	if( std::memcmp( h.magic, ttFileMagic, sizeof(h.magic) ) != 0 || h.version != ttFileVersion || h.clusterSize != sizeof(ttCluster) || h.elements == 0 )
+	{
+		return false;
+	}
+	// the number of clusters comes from the file, the size of the table must not overflow
+	if( h.elements > ( SIZE_MAX - ttFileHeaderSize ) / sizeof(ttCluster) )
+	{
+		return false;
+	}
+	const unsigned long long int bytes = h.elements * sizeof(ttCluster);
+
+#ifdef __linux__
+	// map the file copy on write: the pages are read from the page cache only when they are touched
+	int fd = open( path.c_str(), O_RDONLY );
+	if( fd < 0 )
+	{
+		return false;
+	}
+	struct stat st;
+	if( fstat( fd, &st ) != 0 || (unsigned long long int)st.st_size < ttFileHeaderSize + bytes )
+	{
+		close( fd );
+		return false;
+	}
+	void* mem = mmap( nullptr, ttFileHeaderSize + bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( mem == MAP_FAILED )
+	{
+		return false;
+	}
+
+	_free();
+	_table = reinterpret_cast<ttCluster*>( static_cast<char*>(mem) + ttFileHeaderSize );
+	_elements = h.elements;
+	_memoryType = memoryType::mappedFile;
+#else
+	std::ifstream f( path, std::ios::binary | std::ios::ate );
+	if( !f || (unsigned long long int)f.tellg() < ttFileHeaderSize + bytes || !f.seekg( ttFileHeaderSize ) )
+	{
+		return false;
+	}
+	_free();
+	_elements = h.elements;
+	_allocate( bytes );
+	if( !f.read( reinterpret_cast<char*>(_table), (std::streamsize)bytes ) )
+	{
+		clear();
+		return false;
+	}
+#endif
+	_generation = h.generation;
+	return true;
+}
 
 unsigned long int transpositionTable::setSize(unsigned long int mbSize)
 {
 
 	long long unsigned int size = (long unsigned int)( ((unsigned long long int)mbSize << 20) / sizeof(ttCluster));
+
+	_free();
 	_elements = size;
+	_allocate((unsigned long long int)mbSize << 20);
+
+	return _elements * 4;
+}
 
-	_table.clear();
-	_table.shrink_to_fit();
-	try
+bool transpositionTable::setLargePages(bool enable)
+{
+	if( enable == _largePages )
 	{
-		_table.resize(_elements);
+		return false;
 	}
-	catch(...)
+	_largePages = enable;
+	if( !_table )
 	{
-		std::cerr << "Failed to allocate " << mbSize<< "MB for transposition table." << std::endl;
-		exit(EXIT_FAILURE);
+		return false;
+	}
+	// reallocate the table with the same size
+	_free();
+	_allocate( _elements * sizeof(ttCluster) );
+	return true;
+}
+
+std::string transpositionTable::getMemoryTypeName(const memoryType t)
+{
+	switch(t)
+	{
+	case memoryType::transparentHugePages:
+		return "transparent huge pages";
+	case memoryType::hugePages2MB:
+		return "2MB huge pages";
+	case memoryType::hugePages1GB:
+		return "1GB huge pages";
+	case memoryType::mappedFile:
+		return "memory mapped file";
+	case memoryType::normalPages:
+	default:
+		return "normal pages";
 	}
-	return _elements * 4;
 }
 
 void transpositionTable::newSearch() {_generation++;}
 
-static ttEntry null(0,SCORE_NONE, typeVoid, -100, 0, 0, 0);
-ttEntry* transpositionTable::probe( const HashKey& k )
+static const ttEntry null(0,SCORE_NONE, typeVoid, -100, 0, 0, 0);
+ttEntry transpositionTable::probe( const HashKey& k ) const
 {
 
 	const auto key = k.getKey();
 
-	ttCluster& ttc = findCluster(key);
-	unsigned int keyH = (unsigned int)(key >> 32);
+	const ttCluster& ttc = findCluster(key);
+	unsigned int keyL = (unsigned int)key;
 
-	auto it = std::find_if (ttc.begin(), ttc.end(), [keyH](ttEntry p){return p.getKey()==keyH;});
-	if( it != ttc.end())
+	searchStatistics::increment(searchStatistics::probes);
+	for( auto& slot: ttc )
 	{
-		return it;
+		const ttEntry tte = slot.load();
+		if( tte.getKey() == keyL )
+		{
+			searchStatistics::increment( tte.getType() == typeExact ? searchStatistics::hitExact : tte.getType() == typeScoreLowerThanAlpha ? searchStatistics::hitUpperBound : searchStatistics::hitLowerBound );
+			return tte;
+		}
 	}
 
-	return &null;
+	return null;
 }
 
 
@@ -96,85 +348,86 @@ void transpositionTable::store(const HashKey& k, Score value, unsigned char type
 	}
 
 	const auto key = k.getKey();
-	ttEntry *candidate;
-	unsigned int keyH = (unsigned int)(key >> 32); // Use the high 32 bits as key inside the cluster
+	unsigned int keyL = (unsigned int)key; // Use the low 32 bits as key inside the cluster, the cluster index comes from the high ones
 
 	ttCluster& ttc = findCluster(key);
 
-	auto it = std::find_if (ttc.begin(), ttc.end(), [keyH](ttEntry p){return (!p.getKey()) || (p.getKey()==keyH);});
-	if( it != ttc.end())
+	// the slots are shared with the other threads, work on a decoded snapshot of the cluster
+	std::array<ttEntry, std::tuple_size<ttCluster::array>::value> entries;
+	std::transform(ttc.begin(), ttc.end(), entries.begin(), [](const ttPackedEntry& p){ return p.load(); });
+
+	auto it = std::find_if (entries.begin(), entries.end(), [keyL](const ttEntry& p){return (!p.getKey()) || (p.getKey()==keyL);});
+	auto candidate = it;
+	if( it != entries.end())
 	{
-		candidate = it;
+		searchStatistics::increment( it->getKey() == keyL ? searchStatistics::storeSameKey : searchStatistics::storeEmpty );
 	}
 	else
 	{
-		candidate = &ttc[0];
-		for(auto& d: ttc)
+		searchStatistics::increment(searchStatistics::storeReplace);
+		candidate = entries.begin();
+		for(auto d = entries.begin(); d != entries.end(); ++d)
 		{
 			bool cc1,cc2,cc3,cc4;
 
 			cc1 = candidate->getGeneration() == _generation;
-			cc2 = d.getGeneration() == _generation;
-			cc3 = d.getType() == typeExact;
-			cc4 = d.getDepth() < candidate->getDepth();
+			cc2 = d->getGeneration() == _generation;
+			cc3 = d->getType() == typeExact;
+			cc4 = d->getDepth() < candidate->getDepth();
 
 
 			if( (cc1 && cc4) || (!(cc2 || cc3) && (cc4 || cc1)) )
 			{
-				candidate = &d;
+				candidate = d;
 			}
 
 		}
 	}
-	assert(candidate != nullptr);
-	candidate->save(keyH, value, type, depth, move.getPacked(), statValue, _generation);
+	assert(candidate != entries.end());
+	const unsigned short packedMove = move.getPacked() ? move.getPacked() : candidate->getPackedMove();
+	ttc[ candidate - entries.begin() ].save( ttEntry(keyL, value, type, depth, packedMove, statValue, _generation) );
 
 }
 void transpositionTable::clear()
 {
-	ttCluster ttc;
-	ttc.fill(ttEntry(0,0,0,0,0,0,0));
-	std::fill(_table.begin(), _table.end(), ttc);
+	_forEachChunk( []( ttCluster* begin, ttCluster* end ){ std::fill( begin, end, ttCluster() ); } );
 }
 
 inline ttCluster& transpositionTable::findCluster(uint64_t key)
 {
-	return _table[ static_cast<size_t>(((unsigned int)key) % _elements) ];
+	return _table[ _getClusterIndex(key) ];
 }
 
-void transpositionTable::refresh(ttEntry& tte)
+inline const ttCluster& transpositionTable::findCluster(uint64_t key) const
 {
-	tte.setGeneration(_generation);
+	return _table[ _getClusterIndex(key) ];
 }
 
-unsigned int transpositionTable::getFullness() const
+void transpositionTable::refresh(const HashKey& k)
 {
-	unsigned int cnt = 0u;
-	unsigned int end = std::min( 250lu, _elements );
+	const auto key = k.getKey();
+	unsigned int keyL = (unsigned int)key;
 
-	for (auto t = _table.begin(); t != _table.begin()+end; t++)
+	for( auto& slot: findCluster(key) )
 	{
-		cnt+= std::count_if (t->begin(), t->end(), [=](ttEntry d){return d.getGeneration() == this->_generation;});
+		ttEntry tte = slot.load();
+		if( tte.getKey() == keyL )
+		{
+			tte.setGeneration(_generation);
+			slot.save(tte);
+			return;
+		}
 	}
-	return (unsigned int)(cnt*250lu/(end));
 }
 
-
-void PerftTranspositionTable::store(const HashKey& key, signed short int depth, unsigned long long v)
+unsigned int transpositionTable::getFullness() const
 {
-	transpositionTable::getInstance().store(key, Score(v&0x7FFFFF), typeExact, depth, Move::NOMOVE, (v>>23)&0x7FFFFF);
-}
+	unsigned int cnt = 0u;
+	unsigned int end = std::min( 250lu, _elements );
 
-bool PerftTranspositionTable::retrieve(const HashKey& key, unsigned int depth, unsigned long long& res)
-{
-	ttEntry* tte = transpositionTable::getInstance().probe( key );
-	
-	if( tte->getKey() == (key.getKey()>>32) && (unsigned int)tte->getDepth() == depth )
+	for (auto t = _table; t != _table + end; t++)
 	{
-		res = (unsigned long long)(((unsigned int)tte->getValue())&0x7FFFFF) + (((unsigned long long)((unsigned int)tte->getStaticValue())&0x7FFFFF)<<23);
-
-		return true;
+		cnt+= std::count_if (t->begin(), t->end(), [=](const ttPackedEntry& d){return d.load().getGeneration() == this->_generation;});
 	}
-	return false;
-	
+	return (unsigned int)(cnt*250lu/(end));
 }
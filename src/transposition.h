@@ -20,8 +20,9 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
-#include <vector>
+#include <string>
 
 #include "score.h"
 #include "vajolet.h"
@@ -49,8 +50,7 @@ private:
 	signed int staticValue:23;	/*! 23 bit for the static evalutation (eval())*/
 	signed int type:3;			/*! 2 bit for the type of the entry*/
 							/*  144 bits total =16 bytes*/
-	inline void save(unsigned int Key, Score Value, unsigned char Type, signed short int Depth, unsigned short Move, Score StaticValue, unsigned char gen);
-	inline void setGeneration(unsigned char gen);
+	inline void setGeneration(unsigned char gen){ generation = gen; }
 	
 	friend class transpositionTable;
 public:
@@ -76,29 +76,108 @@ public:
 	
 };
 
-using ttCluster = std::array<ttEntry, 4>;
+/*! \brief lock-free storage of a ttEntry
+	the table is shared by all the search threads without locks: the key is stored xored with the data,
+	so a torn entry (two threads writing the same slot, or a read racing a write) fails the key verification
+	and it's seen as a miss.
+*/
+class ttPackedEntry
+{
+private:
+	std::atomic<uint64_t> _keyData;	/*! 32 bit verification key | 16 bit depth | 16 bit move*/
+	std::atomic<uint64_t> _data;	/*! 3 bit type | 8 bit generation | 23 bit static value | 23 bit value*/
+
+	static uint32_t _fold(const uint64_t keyData, const uint64_t data) { return (uint32_t)keyData ^ (uint32_t)data ^ (uint32_t)(data >> 32); }
+	static Score _signExtend23(const uint64_t x) { return (Score)((int32_t)((uint32_t)x << 9) >> 9); }
+
+public:
+	explicit ttPackedEntry(): _keyData(0), _data(0){}
+	ttPackedEntry(const ttPackedEntry& other): _keyData(other._keyData.load(std::memory_order_relaxed)), _data(other._data.load(std::memory_order_relaxed)){}
+	ttPackedEntry& operator=(const ttPackedEntry& other)
+	{
+		_keyData.store(other._keyData.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_data.store(other._data.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return *this;
+	}
+
+	inline ttEntry load() const
+	{
+		const uint64_t keyData = _keyData.load(std::memory_order_relaxed);
+		const uint64_t data = _data.load(std::memory_order_relaxed);
+		const unsigned int key = (unsigned int)(keyData >> 32) ^ _fold(keyData, data);
+		return ttEntry(key, _signExtend23(data), (unsigned char)((data >> 54) & 0x7), (signed short int)(keyData >> 16), (unsigned short)keyData, _signExtend23(data >> 23), (unsigned char)(data >> 46));
+	}
+
+	inline void save(const ttEntry& e)
+	{
+		const uint64_t data =
+			  ((uint64_t)(uint32_t)e.getValue() & 0x7FFFFF)
+			| (((uint64_t)(uint32_t)e.getStaticValue() & 0x7FFFFF) << 23)
+			| ((uint64_t)e.getGeneration() << 46)
+			| ((uint64_t)(e.getType() & 0x7) << 54);
+		uint64_t keyData = (uint64_t)e.getPackedMove() | ((uint64_t)(uint16_t)e.getDepth() << 16);
+		keyData |= (uint64_t)(e.getKey() ^ _fold(keyData, data)) << 32;
+
+		_data.store(data, std::memory_order_relaxed);
+		_keyData.store(keyData, std::memory_order_relaxed);
+	}
+};
+
+/*! \brief a cluster of entries fills exactly one cache line
+*/
+struct alignas(64) ttCluster: public std::array<ttPackedEntry, 4>
+{
+};
+
+static_assert(sizeof(ttCluster) == 64, "a ttCluster shall fit a cache line");
+static_assert(alignof(ttCluster) == 64, "a ttCluster shall be aligned to a cache line");
 
 
 
 class transpositionTable
 {
+public:
+	enum class memoryType
+	{
+		normalPages,
+		transparentHugePages,
+		hugePages2MB,
+		hugePages1GB,
+		mappedFile
+	};
+
 private:
-	std::vector<ttCluster> _table;
+	ttCluster* _table;
 	unsigned long int _elements;
 	unsigned char _generation;
+	memoryType _memoryType;
+	bool _largePages;
 
 	explicit transpositionTable()
 	{
-		_table.clear();
-		_table.shrink_to_fit();
+		_table = nullptr;
+		_memoryType = memoryType::normalPages;
+		_largePages = false;
 
 		_generation = 0;
 		_elements = 1;
 	}
+	~transpositionTable();
 	
 	transpositionTable(transpositionTable const&) = delete;
 	void operator=(transpositionTable const&) = delete;
+	inline size_t _getClusterIndex(uint64_t key) const
+	{
+		__extension__ using uint128 = unsigned __int128;
+		// multiply-high maps the full 64 bit key on [0, _elements) without a division and without limits on the number of clusters.
+		// the index only overlaps the 32 bits stored in the entry when the table has more than 2^32 clusters
+		return static_cast<size_t>( ( (uint128)key * (uint128)_elements ) >> 64 );
+	}
 	ttCluster& findCluster(uint64_t key);
+	const ttCluster& findCluster(uint64_t key) const;
+	void _allocate(unsigned long long int bytes);
+	void _free();
+	void _forEachChunk( void (*job)( ttCluster* begin, ttCluster* end ) );
 	
 
 public:
@@ -113,8 +192,24 @@ public:
 	
 	void newSearch();
 	unsigned long int setSize(unsigned long int mbSize);
-	void refresh(ttEntry& tte);
-	ttEntry* probe(const HashKey& k);
+	bool setLargePages(bool enable);
+	memoryType getMemoryType() const { return _memoryType; }
+	static std::string getMemoryTypeName(const memoryType t);
+	bool saveToFile(const std::string& path) const;
+	bool loadFromFile(const std::string& path);
+	unsigned long int getElements() const { return _elements * 4; }
+	void refresh(const HashKey& k);
+	ttEntry probe(const HashKey& k) const;
+	/*! \brief start loading the cluster of the key in the cache, to hide the memory latency of the following probe
+		nothing is done before the table is allocated, doMove is also used by perft, the tuner and the benchmarks
+	*/
+	inline void prefetch(const uint64_t key) const
+	{
+		if( _table )
+		{
+			__builtin_prefetch( &_table[ _getClusterIndex(key) ] );
+		}
+	}
 	void store(const HashKey& k, Score value, unsigned char type, signed short int depth, const Move& move, Score statValue);
 	unsigned int getFullness() const;
 	
@@ -151,16 +246,6 @@ public:
 	}
 };
 
-class PerftTranspositionTable
-{
-public:
-	explicit PerftTranspositionTable(){}
-	
-	void store(const HashKey& key, signed short int depth, unsigned long long v);
-	bool retrieve(const HashKey& key, unsigned int depth, unsigned long long& res);
-};
-
-
 
 
 #endif /* TRANSPOSITION_H_ */
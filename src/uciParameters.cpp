@@ -26,5 +26,8 @@ unsigned int uciParameters::SyzygyProbeDepth = 1;
 bool uciParameters::Syzygy50MoveRule =  true;
 bool uciParameters::Ponder;
 bool uciParameters::Chess960 = false;
+bool uciParameters::largePages = true;
+std::string uciParameters::evalFile = "<empty>";
+bool uciParameters::lazyEval = false;
 
 
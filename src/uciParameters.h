@@ -32,6 +32,9 @@ public:
 	static bool Syzygy50MoveRule;
 	static bool Ponder;
 	static bool Chess960;
+	static bool largePages;
+	static std::string evalFile;
+	static bool lazyEval;
 };
 
 #endif
@@ -29,6 +29,12 @@
 //#define DISABLE_TIME_DIPENDENT_OUTPUT
 //#define ENABLE_CHECK_CONSISTENCY
 
+//---------------------------------------------
+//	constants
+//---------------------------------------------
+static const unsigned int MAX_PLY = 800;		// deepest ply reached by the search
+static const unsigned int MAX_GAME_PLY = 1024;	// longest game history accepted by the position command
+
 
 
 #endif /* VAJOLET_H_ */
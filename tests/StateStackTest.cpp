@@ -0,0 +1,97 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include "gtest/gtest.h"
+#include "position.h"
+#include "stateStack.h"
+
+
+namespace {
+
+	TEST(StateStack, pushPop)
+	{
+		StateStack<10> st;
+		st.reset();
+		st.back().setCurrentMove( Move( E2, E4 ) );
+		ASSERT_EQ( 1u, st.size() );
+
+		st.push();
+		ASSERT_EQ( 2u, st.size() );
+		// the persistent part of the state is inherited from the previous one
+		st.back().copyPersistentData( st.previous() );
+		ASSERT_EQ( Move( E2, E4 ), st.back().getCurrentMove() );
+		st.back().setCurrentMove( Move( E7, E5 ) );
+		ASSERT_EQ( Move( E2, E4 ), st[0].getCurrentMove() );
+		ASSERT_EQ( Move( E7, E5 ), st[1].getCurrentMove() );
+
+		st.pop();
+		ASSERT_EQ( 1u, st.size() );
+		ASSERT_EQ( Move( E2, E4 ), st.back().getCurrentMove() );
+	}
+
+	TEST(StateStack, copyTail)
+	{
+		StateStack<10> st;
+		st.reset();
+		st.back().setCurrentMove( Move( E2, E4 ) );
+		st.push();
+		st.back().setCurrentMove( Move( E7, E5 ) );
+		st.push();
+		st.back().setCurrentMove( Move( G1, F3 ) );
+
+		StateStack<10> copy( st );
+		ASSERT_EQ( 3u, copy.size() );
+		ASSERT_EQ( Move( E2, E4 ), copy[0].getCurrentMove() );
+		ASSERT_EQ( Move( G1, F3 ), copy[2].getCurrentMove() );
+
+		copy.copyTail( st, 2 );
+		ASSERT_EQ( 2u, copy.size() );
+		ASSERT_EQ( Move( E7, E5 ), copy[0].getCurrentMove() );
+		ASSERT_EQ( Move( G1, F3 ), copy.back().getCurrentMove() );
+
+		// at least the actual state is always copied
+		copy.copyTail( st, 0 );
+		ASSERT_EQ( 1u, copy.size() );
+		ASSERT_EQ( Move( G1, F3 ), copy.back().getCurrentMove() );
+	}
+
+	TEST(StateStack, positionRecentHistory)
+	{
+		Position pos;
+		pos.setupFromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+		pos.doMove( Move( E2, E4 ) );
+		pos.doMove( Move( E7, E5 ) );
+		pos.doMove( Move( G1, F3 ) );
+		pos.doMove( Move( G8, F6 ) );
+		pos.doMove( Move( F3, G1 ) );
+		pos.doMove( Move( F6, G8 ) );
+		ASSERT_TRUE( pos.hasRepeated() );
+
+		Position copy;
+		copy.copyWithRecentHistory( pos );
+		// the states before the last pawn move are not copied
+		ASSERT_EQ( 5u, copy.getStateSize() );
+		ASSERT_EQ( pos.getActualState().getKey(), copy.getActualState().getKey() );
+		ASSERT_TRUE( copy.hasRepeated() );
+
+		copy.doMove( Move( G1, F3 ) );
+		ASSERT_TRUE( copy.hasRepeated() );
+		copy.undoMove();
+		copy.doMove( Move( B1, C3 ) );
+		ASSERT_FALSE( copy.hasRepeated() );
+	}
+}
@@ -0,0 +1,272 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "libchess.h"
+#include "movegen.h"
+#include "moveList.h"
+#include "position.h"
+#include "transposition.h"
+
+namespace {
+
+	// positions without check: perft positions, middlegames and endgames
+	const std::vector<std::string> quietCorpus = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+		"8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+		"3r2k1/p2r1p1p/1p2p1p1/q4n2/3P4/PQ5P/1P1RNPP1/3R2K1 b - - 0 1"
+	};
+
+	// positions with the side to move in check, used by the evasion generators
+	const std::vector<std::string> checkCorpus = {
+		"rnbqkbnr/ppppp1pp/8/5p1Q/4P3/8/PPPP1PPP/RNB1KBNR b KQkq - 1 2",
+		"r1bqkbnr/pppp1Qpp/2n5/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/6P1/4P3/8 b - - 0 1",
+		"4k3/8/8/8/8/8/3q4/4K3 w - - 0 1",
+		"rnbqk1nr/pppp1ppp/8/4p3/1b1P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 3",
+		"3k4/8/8/8/8/8/2n5/K7 w - - 0 1"
+	};
+
+	std::vector<std::unique_ptr<Position>> setupCorpus( const std::vector<std::string>& fens, const Position::pawnHash usePawnHash = Position::pawnHash::off )
+	{
+		std::vector<std::unique_ptr<Position>> positions;
+		for( auto& fen: fens )
+		{
+			positions.emplace_back( std::make_unique<Position>( usePawnHash ) );
+			positions.back()->setupFromFen( fen );
+		}
+		return positions;
+	}
+
+	std::vector<MoveList<MAX_MOVE_PER_POSITION>> legalMoves( const std::vector<std::unique_ptr<Position>>& positions )
+	{
+		std::vector<MoveList<MAX_MOVE_PER_POSITION>> moves( positions.size() );
+		for( unsigned int i = 0; i < positions.size(); ++i )
+		{
+			positions[i]->getLegalMoves( moves[i] );
+		}
+		return moves;
+	}
+
+	template<Movegen::genType type>
+	void generateMoves( benchmark::State& st )
+	{
+		constexpr bool evasion = type == Movegen::genType::captureEvasionMg || type == Movegen::genType::quietEvasionMg;
+		const auto positions = setupCorpus( evasion ? checkCorpus : quietCorpus );
+		uint64_t moves = 0;
+		for( auto _: st )
+		{
+			for( auto& pos: positions )
+			{
+				MoveList<MAX_MOVE_PER_POSITION> ml;
+				pos->getMoveGen().generateMoves<type>( ml );
+				benchmark::DoNotOptimize( ml );
+				moves += ml.size();
+			}
+		}
+		st.SetItemsProcessed( st.iterations() * positions.size() );
+		st.counters["moves"] = benchmark::Counter( moves, benchmark::Counter::kIsRate );
+	}
+	BENCHMARK_TEMPLATE(generateMoves, Movegen::genType::captureMg);
+	BENCHMARK_TEMPLATE(generateMoves, Movegen::genType::quietMg);
+	BENCHMARK_TEMPLATE(generateMoves, Movegen::genType::quietChecksMg);
+	BENCHMARK_TEMPLATE(generateMoves, Movegen::genType::allMg);
+	BENCHMARK_TEMPLATE(generateMoves, Movegen::genType::captureEvasionMg);
+	BENCHMARK_TEMPLATE(generateMoves, Movegen::genType::quietEvasionMg);
+
+	void doUndoMove( benchmark::State& st )
+	{
+		const auto positions = setupCorpus( quietCorpus );
+		auto moves = legalMoves( positions );
+		uint64_t n = 0;
+		for( auto _: st )
+		{
+			for( unsigned int i = 0; i < positions.size(); ++i )
+			{
+				Position& pos = *positions[i];
+				for( auto& m: moves[i] )
+				{
+					pos.doMove( m );
+					benchmark::DoNotOptimize( pos.getActualState().getKey() );
+					pos.undoMove();
+					++n;
+				}
+			}
+		}
+		st.SetItemsProcessed( n );
+	}
+	BENCHMARK(doUndoMove);
+
+	void see( benchmark::State& st )
+	{
+		const auto positions = setupCorpus( quietCorpus );
+		std::vector<MoveList<MAX_MOVE_PER_POSITION>> captures( positions.size() );
+		for( unsigned int i = 0; i < positions.size(); ++i )
+		{
+			positions[i]->getMoveGen().generateMoves<Movegen::genType::captureMg>( captures[i] );
+		}
+		uint64_t n = 0;
+		for( auto _: st )
+		{
+			for( unsigned int i = 0; i < positions.size(); ++i )
+			{
+				for( auto& m: captures[i] )
+				{
+					benchmark::DoNotOptimize( positions[i]->see( m ) );
+					++n;
+				}
+			}
+		}
+		st.SetItemsProcessed( n );
+	}
+	BENCHMARK(see);
+
+	void isMoveLegal( benchmark::State& st )
+	{
+		// the legal moves of all the positions are tested on every position, most of them are illegal elsewhere
+		const auto positions = setupCorpus( quietCorpus );
+		std::vector<Move> candidates;
+		for( auto& ml: legalMoves( positions ) )
+		{
+			candidates.insert( candidates.end(), ml.begin(), ml.end() );
+		}
+		uint64_t n = 0;
+		for( auto _: st )
+		{
+			for( auto& pos: positions )
+			{
+				for( auto& m: candidates )
+				{
+					benchmark::DoNotOptimize( pos->isMoveLegal( m ) );
+				}
+				n += candidates.size();
+			}
+		}
+		st.SetItemsProcessed( n );
+	}
+	BENCHMARK(isMoveLegal);
+
+	void moveGivesCheck( benchmark::State& st )
+	{
+		const auto positions = setupCorpus( quietCorpus );
+		auto moves = legalMoves( positions );
+		uint64_t n = 0;
+		for( auto _: st )
+		{
+			for( unsigned int i = 0; i < positions.size(); ++i )
+			{
+				for( auto& m: moves[i] )
+				{
+					benchmark::DoNotOptimize( positions[i]->moveGivesCheck( m ) );
+					++n;
+				}
+			}
+		}
+		st.SetItemsProcessed( n );
+	}
+	BENCHMARK(moveGivesCheck);
+
+	// argument 0: full evaluation without hash tables, 1: with pawn and material hash tables
+	void eval( benchmark::State& st )
+	{
+		const auto positions = setupCorpus( quietCorpus, st.range(0) ? Position::pawnHash::on : Position::pawnHash::off );
+		for( auto _: st )
+		{
+			for( auto& pos: positions )
+			{
+				benchmark::DoNotOptimize( pos->eval<false>() );
+			}
+		}
+		st.SetItemsProcessed( st.iterations() * positions.size() );
+	}
+	BENCHMARK(eval)->Arg(0)->Arg(1);
+
+	std::vector<HashKey> ttKeys()
+	{
+		std::mt19937_64 rnd( 1 );
+		std::vector<HashKey> keys( 4096 );
+		for( auto& k: keys )
+		{
+			k = HashKey( rnd() );
+		}
+		return keys;
+	}
+
+	void ttStore( benchmark::State& st )
+	{
+		transpositionTable& tt = transpositionTable::getInstance();
+		tt.setSize( 16 );
+		tt.clear();
+		const auto keys = ttKeys();
+		for( auto _: st )
+		{
+			for( auto& k: keys )
+			{
+				tt.store( k, 100, typeExact, 10, Move( E2, E4 ), 50 );
+			}
+		}
+		st.SetItemsProcessed( st.iterations() * keys.size() );
+	}
+	BENCHMARK(ttStore);
+
+	void ttProbe( benchmark::State& st )
+	{
+		transpositionTable& tt = transpositionTable::getInstance();
+		tt.setSize( 16 );
+		tt.clear();
+		const auto keys = ttKeys();
+		// half of the keys are stored, so both hits and misses are measured
+		for( unsigned int i = 0; i < keys.size(); i += 2 )
+		{
+			tt.store( keys[i], 100, typeExact, 10, Move( E2, E4 ), 50 );
+		}
+		for( auto _: st )
+		{
+			for( auto& k: keys )
+			{
+				benchmark::DoNotOptimize( tt.probe( k ) );
+			}
+		}
+		st.SetItemsProcessed( st.iterations() * keys.size() );
+	}
+	BENCHMARK(ttProbe);
+}
+
+int main( int argc, char** argv )
+{
+	libChessInit();
+	benchmark::Initialize( &argc, argv );
+	if( benchmark::ReportUnrecognizedArguments( argc, argv ) )
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,194 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "movegen.h"
+#include "moveList.h"
+#include "nnue.h"
+#include "position.h"
+
+template<typename T>
+static void writeRandomValues(std::ofstream& f, std::mt19937& rnd, const unsigned int count, const int range)
+{
+	std::uniform_int_distribution<int> dist(-range, range);
+	for (unsigned int i = 0; i < count; ++i) {
+		const T v = (T)dist(rnd);
+		f.write(reinterpret_cast<const char*>(&v), sizeof(v));
+	}
+}
+
+static void writeRandomNet(const std::string& path, const unsigned int seed, const bool truncated = false)
+{
+	std::mt19937 rnd(seed);
+	std::ofstream f(path, std::ios::binary | std::ios::trunc);
+	const uint32_t header[3] = { Nnue::fileVersion, Nnue::halfDimensions, Nnue::hiddenDimensions };
+	f.write(Nnue::fileMagic, sizeof(Nnue::fileMagic));
+	f.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	writeRandomValues<int16_t>(f, rnd, Nnue::halfDimensions, 64);
+	writeRandomValues<int16_t>(f, rnd, Nnue::inputDimensions * Nnue::halfDimensions, 32);
+	writeRandomValues<int32_t>(f, rnd, Nnue::hiddenDimensions, 2000);
+	writeRandomValues<int8_t>(f, rnd, Nnue::hiddenDimensions * 2 * Nnue::halfDimensions, 8);
+	writeRandomValues<int32_t>(f, rnd, Nnue::hiddenDimensions, 2000);
+	writeRandomValues<int8_t>(f, rnd, Nnue::hiddenDimensions * Nnue::hiddenDimensions, 16);
+	writeRandomValues<int32_t>(f, rnd, 1, 2000);
+	writeRandomValues<int8_t>(f, rnd, truncated ? Nnue::hiddenDimensions - 1 : Nnue::hiddenDimensions, 64);
+}
+
+static Score freshEval(const Position& pos)
+{
+	Position p(Position::pawnHash::off);
+	p.setupFromFen(pos.getFen());
+	return p.getStaticEval();
+}
+
+TEST(Nnue, loadFromFile) {
+	Nnue& nnue = Nnue::getInstance();
+
+	EXPECT_FALSE(nnue.loadFromFile("missing-net.bin"));
+	EXPECT_FALSE(nnue.isLoaded());
+
+	writeRandomNet("nnue-test.bin", 1, true);
+	EXPECT_FALSE(nnue.loadFromFile("nnue-test.bin"));
+	EXPECT_FALSE(nnue.isLoaded());
+	EXPECT_EQ(nnue.getId(), 0u);
+
+	writeRandomNet("nnue-test.bin", 1);
+	ASSERT_TRUE(nnue.loadFromFile("nnue-test.bin"));
+	EXPECT_TRUE(nnue.isLoaded());
+	const unsigned int id = nnue.getId();
+	EXPECT_NE(id, 0u);
+
+	// every load gives a new id, also when the net is the same
+	ASSERT_TRUE(nnue.loadFromFile("nnue-test.bin"));
+	EXPECT_NE(nnue.getId(), id);
+
+	nnue.unload();
+	EXPECT_FALSE(nnue.isLoaded());
+	EXPECT_EQ(nnue.getId(), 0u);
+	std::remove("nnue-test.bin");
+}
+
+TEST(Nnue, incrementalUpdate) {
+	writeRandomNet("nnue-test.bin", 2);
+	ASSERT_TRUE(Nnue::getInstance().loadFromFile("nnue-test.bin"));
+
+	// castling, en passant and promotions, with and without captures
+	const std::vector<std::string> fens = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+	};
+
+	std::mt19937 rnd(3);
+	Position pos(Position::pawnHash::off);
+	for (const auto& fen : fens) {
+		pos.setupFromFen(fen);
+		std::vector<Score> evals = { pos.getStaticEval() };
+		EXPECT_EQ(evals.back(), freshEval(pos));
+
+		std::vector<bool> nullMoves;
+		for (unsigned int ply = 0; ply < 40; ++ply) {
+			MoveList<MAX_MOVE_PER_POSITION> moveList;
+			Movegen mg(pos);
+			mg.generateMoves<Movegen::genType::allMg>(moveList);
+			if (moveList.size() == 0) {
+				break;
+			}
+			const bool nullMove = !pos.isInCheck() && rnd() % 8 == 0;
+			if (nullMove) {
+				pos.doNullMove();
+			}
+			else {
+				pos.doMove(moveList.get(rnd() % moveList.size()));
+			}
+			nullMoves.push_back(nullMove);
+
+			// the position is not always evaluated, to have accumulators computed from a far ancestor
+			if (rnd() % 3) {
+				evals.push_back(pos.getStaticEval());
+				EXPECT_EQ(evals.back(), freshEval(pos)) << pos.getFen();
+			}
+			else {
+				evals.push_back(freshEval(pos));
+			}
+		}
+
+		// after undoing the moves the older accumulators are still valid
+		while (!nullMoves.empty()) {
+			if (nullMoves.back()) {
+				pos.undoNullMove();
+			}
+			else {
+				pos.undoMove();
+			}
+			nullMoves.pop_back();
+			evals.pop_back();
+			EXPECT_EQ(pos.getStaticEval(), evals.back()) << pos.getFen();
+		}
+	}
+
+	Nnue::getInstance().unload();
+	std::remove("nnue-test.bin");
+}
+
+TEST(Nnue, symmetry) {
+	writeRandomNet("nnue-test.bin", 4);
+	ASSERT_TRUE(Nnue::getInstance().loadFromFile("nnue-test.bin"));
+
+	// each side sees the board from its own point of view, so the net is color symmetric
+	Position pos(Position::pawnHash::off);
+	pos.setupFromFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	Position sym(Position::pawnHash::off);
+	sym.setupFromFen(pos.getSymmetricFen());
+	EXPECT_EQ(pos.getStaticEval(), sym.getStaticEval());
+
+	Nnue::getInstance().unload();
+	std::remove("nnue-test.bin");
+}
+
+TEST(Nnue, classicalFallback) {
+	writeRandomNet("nnue-test.bin", 5);
+	ASSERT_TRUE(Nnue::getInstance().loadFromFile("nnue-test.bin"));
+
+	Position pos;
+	pos.setupFromFen("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+	const Score nnueEval = pos.getStaticEval();
+	EXPECT_EQ(nnueEval, freshEval(pos));
+
+	// the position set up with the net falls back to the classical evaluation as soon as the net is unloaded
+	Nnue::getInstance().unload();
+	const Score classicalEval = pos.eval<false>();
+	EXPECT_EQ(pos.getStaticEval(), classicalEval);
+
+	// a new setup drops the values cached with the net
+	ASSERT_TRUE(Nnue::getInstance().loadFromFile("nnue-test.bin"));
+	pos.setupFromFen(pos.getFen());
+	EXPECT_EQ(pos.getStaticEval(), nnueEval);
+	Nnue::getInstance().unload();
+	pos.setupFromFen(pos.getFen());
+	EXPECT_EQ(pos.getStaticEval(), classicalEval);
+
+	std::remove("nnue-test.bin");
+}
@@ -1,4 +1,5 @@
 #include <fstream>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -27,7 +28,7 @@ TEST(PerftTest, frcTest) {
 			found=line.find_first_of(",",found + 1 );
 			
 			unsigned long long ull = std::stoull (line.substr(start, found-start));
-			unsigned long long int res = Perft(pos).perft(6);
+			unsigned long long int res = Perft(pos).perft(6, std::thread::hardware_concurrency());
 			std::cout<<++n<<" perft(6) = "<<res<<std::endl;
 			ASSERT_EQ(ull, res);
 		}
@@ -57,7 +58,7 @@ TEST(PerftTest, perft) {
 			found=line.find_first_of(",",found + 1 );
 			
 			unsigned long long ull = std::stoull (line.substr(start, found-start));
-			unsigned long long int res = Perft(pos).perft(++i);
+			unsigned long long int res = Perft(pos).perft(++i, std::thread::hardware_concurrency());
 			std::cout<<n<<" perft("<<i<<") = "<<res<<std::endl;
 			ASSERT_EQ(ull, res);
 		}
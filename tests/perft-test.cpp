@@ -2,7 +2,7 @@
 #include "gtest/gtest.h"
 #include "perft.h"
 #include "position.h"
-#include "transposition.h"
+#include "perftTable.h"
 
 typedef struct _positions
 {
@@ -39,8 +39,24 @@ TEST(PerftTest, perft) {
 	}
 }
 
+TEST(PerftTest, perftParallel) {
+	Position pos;
+	for (auto & p : perftPos)
+	{
+		pos.setupFromFen(p.Fen); 
+		for( unsigned int i = 0; i < 4 && i < p.PerftValue.size(); i++)
+		{
+			EXPECT_EQ(Perft(pos).perft(i+1, 4), p.PerftValue[i]);
+		}
+	}
+	// the threads are limited to the hardware ones
+	EXPECT_EQ(Perft(pos).perft(3, 100000), perftPos.back().PerftValue[2]);
+	EXPECT_EQ(Perft(pos).perft(0, 4), 1u);
+	EXPECT_EQ(Perft(pos).perft(0), 1u);
+}
+
 TEST(PerftTest, perftHash) {
-	transpositionTable::getInstance().setSize(1);
+	PerftTranspositionTable::getInstance().setSize(1);
 	Position pos;
 	for (auto & p : perftPos)
 	{
@@ -55,6 +71,24 @@ TEST(PerftTest, perftHash) {
 	}
 }
 
+TEST(PerftTest, perftTable) {
+	PerftTranspositionTable& tt = PerftTranspositionTable::getInstance();
+	tt.setSize(1);
+
+	const HashKey k(0x0123456789ABCDEFull);
+	const unsigned long long count = ( 1ull << 50 ) + 12345ull;
+	tt.store(k, 9, count);
+
+	unsigned long long res = 0;
+	EXPECT_TRUE(tt.retrieve(k, 9, res));
+	EXPECT_EQ(res, count);
+	EXPECT_FALSE(tt.retrieve(k, 8, res));
+	EXPECT_FALSE(tt.retrieve(HashKey(0x1123456789ABCDEFull), 9, res));
+
+	tt.clear();
+	EXPECT_FALSE(tt.retrieve(k, 9, res));
+}
+
 TEST(PerftTest, divide) {
 	
 	std::streambuf* oldCoutStreamBuf = std::cout.rdbuf();
@@ -70,6 +104,7 @@ TEST(PerftTest, divide) {
 			EXPECT_EQ(Perft(pos).divide(i+1), p.PerftValue[i]);
 		}
 	}
+	EXPECT_EQ(Perft(pos).divide(0, 4), 1u);
 	
 	std::cout.rdbuf( oldCoutStreamBuf );
 }
\ No newline at end of file
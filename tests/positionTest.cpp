@@ -165,3 +165,86 @@ TEST(PositionTest, getFen) {
 
 	}
 }
+
+TEST(PositionTest, evalMaterialTable) {
+	// the material hash table shall not change the evaluation
+	Position cached;
+	Position uncached(Position::pawnHash::off);
+	const std::string fens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"k7/8/8/8/8/8/8/5BNK w - - 0 1",
+		"kb6/8/8/8/8/8/4PPPP/7K b - - 0 1",
+		"kb6/pp6/8/8/8/8/5PPP/5B1K w - - 0 1",
+		"1rr1k3/8/8/8/3n4/8/8/Q3K2b w - - 0 1",
+		"k7/8/8/8/8/8/8/4RRNK b - - 0 1"
+	};
+	for (auto & f : fens)
+	{
+		cached.setupFromFen(f);
+		uncached.setupFromFen(f);
+		// the second call is served by the table
+		EXPECT_EQ(cached.eval<false>(), uncached.eval<false>());
+		EXPECT_EQ(cached.eval<false>(), uncached.eval<false>());
+	}
+}
+
+TEST(PositionTest, getStaticEval) {
+	Position pos;
+	for (auto & p : perftPos)
+	{
+		pos.setupFromFen(p.Fen);
+		// the second call is served by the eval cache
+		EXPECT_EQ(pos.getStaticEval(), pos.eval<false>());
+		EXPECT_EQ(pos.getStaticEval(), pos.eval<false>());
+	}
+}
+
+TEST(PositionTest, evalSymmetryAndReference) {
+	// reference values of the evaluation with evalKingSafety<c> called once per king,
+	// every build (64OLD .. 64AVX2) shall give exactly the same results and the mirrored position shall evaluate the same
+	static const std::vector<std::pair<std::string, Score>> evalPos = {
+		{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 729},
+		{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3213},
+		{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", -562},
+		{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 12654},
+		{"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 12654},
+		{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", -11947},
+		{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 729},
+		{"r1bq1rk1/pp3ppp/2n1p3/3pP1N1/3P4/3B4/PP3PPP/R2QK2R w KQ - 0 12", 6461},
+		{"r1b2rk1/pp1n1ppp/2p1p3/q2nP1NQ/3P4/2PB4/P4PPP/R1B2RK1 b - - 0 14", -15723},
+		{"6k1/5ppp/8/8/8/8/5PPP/3R2K1 b - - 0 1", -59243},
+		{"2kr3r/ppp2ppp/2n5/2b1q3/4n3/2N1B3/PPP1QPPP/2KR1B1R w - - 0 12", 2379},
+		{"r4rk1/ppp2ppp/2n5/3qp1N1/8/3P1Q2/PPP2PPP/R4RK1 b - - 0 1", -357}
+	};
+
+	Position pos;
+	Position sym;
+	for (auto & p : evalPos)
+	{
+		pos.setupFromFen(p.first);
+		sym.setupFromFen(pos.getSymmetricFen());
+		EXPECT_EQ(pos.eval<false>(), p.second) << p.first;
+		EXPECT_EQ(sym.eval<false>(), p.second) << p.first;
+	}
+}
+
+TEST(PositionTest, lazyEval) {
+	Position pos(Position::pawnHash::off);
+	bool exact;
+
+	// white is a queen up, the expensive terms are skipped
+	pos.setupFromFen("r1b1kbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 0 1");
+	const Score full = pos.eval<false>();
+	Score lazy = pos.eval<false>(-SCORE_INFINITE, 0, exact);
+	EXPECT_FALSE(exact);
+	EXPECT_GE(lazy, 0);
+	EXPECT_GE(full, 0);
+
+	lazy = pos.eval<false>(0, 1, exact);
+	EXPECT_FALSE(exact);
+	EXPECT_GE(lazy, 1);
+
+	// a window around the score requires the full evaluation
+	EXPECT_EQ(pos.eval<false>(full - 1, full + 1, exact), full);
+	EXPECT_TRUE(exact);
+}
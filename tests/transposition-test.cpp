@@ -0,0 +1,212 @@
+/*
+	This file is part of Vajolet.
+
+    Vajolet is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Vajolet is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Vajolet.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hashKey.h"
+#include "move.h"
+#include "searchStatistics.h"
+#include "transposition.h"
+
+// every field of the entry is derived from the key, so a probe hit can be validated
+static Score valueFromKey(unsigned int keyL) { return Score(keyL % 20000) - 10000; }
+static Score staticValueFromKey(unsigned int keyL) { return Score((keyL >> 7) % 20000) - 10000; }
+static signed short int depthFromKey(unsigned int keyL) { return (keyL >> 3) % 100; }
+static unsigned short moveFromKey(unsigned int keyL) { return (unsigned short)((keyL >> 11) | 1); }
+static unsigned char typeFromKey(unsigned int keyL) { return keyL % 3; }
+
+TEST(transpositionTable, storeAndProbe) {
+
+	transpositionTable& tt = transpositionTable::getInstance();
+	tt.setSize(1);
+	tt.clear();
+
+	HashKey k(0x123456789ABCDEF0ull);
+	tt.store(k, -4000, typeScoreLowerThanAlpha, 12, Move(0x1234), -3000);
+
+	ttEntry tte = tt.probe(k);
+	EXPECT_EQ(tte.getKey(), 0x9ABCDEF0u);
+	EXPECT_EQ(tte.getValue(), -4000);
+	EXPECT_EQ(tte.getStaticValue(), -3000);
+	EXPECT_EQ(tte.getDepth(), 12);
+	EXPECT_EQ(tte.getPackedMove(), 0x1234);
+	EXPECT_EQ(tte.getType(), typeScoreLowerThanAlpha);
+
+	// a store without move keeps the old one
+	tt.store(k, 100, typeExact, 14, Move(Move::NOMOVE), 200);
+	tte = tt.probe(k);
+	EXPECT_EQ(tte.getValue(), 100);
+	EXPECT_EQ(tte.getPackedMove(), 0x1234);
+
+	tte = tt.probe(HashKey(0x123456789ABCDEF1ull));
+	EXPECT_EQ(tte.getType(), typeVoid);
+
+	tt.clear();
+}
+
+TEST(transpositionTable, concurrentAccess) {
+
+	transpositionTable& tt = transpositionTable::getInstance();
+	tt.setSize(1);
+	tt.clear();
+
+	const unsigned int threadsNumber = std::max(4u, std::thread::hardware_concurrency());
+	std::atomic<unsigned long long> hits(0);
+	std::atomic<unsigned long long> errors(0);
+
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < threadsNumber; ++t) {
+		threads.emplace_back([&, t]() {
+			std::mt19937_64 rnd(t);
+			for (unsigned int i = 0; i < 200000; ++i) {
+				// 64 different keys sharing a single cluster, to force the threads to write on the same slots
+				const unsigned int keyL = (unsigned int)(rnd() % 64 + 1) * 0x9E3779B1u;
+				const HashKey k(((uint64_t)(keyL & 0x3) << 32) | keyL);
+
+				if (rnd() & 1) {
+					tt.store(k, valueFromKey(keyL), typeFromKey(keyL), depthFromKey(keyL), Move(moveFromKey(keyL)), staticValueFromKey(keyL));
+				}
+				else {
+					const ttEntry tte = tt.probe(k);
+					if (tte.getType() == typeVoid) {
+						continue;
+					}
+					++hits;
+					if (tte.getKey() != keyL
+						|| tte.getValue() != valueFromKey(keyL)
+						|| tte.getStaticValue() != staticValueFromKey(keyL)
+						|| tte.getDepth() != depthFromKey(keyL)
+						|| tte.getPackedMove() != moveFromKey(keyL)
+						|| tte.getType() != typeFromKey(keyL)) {
+						++errors;
+					}
+				}
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	EXPECT_EQ(errors, 0u);
+	EXPECT_GT(hits, 0u);
+
+	tt.clear();
+}
+
+TEST(transpositionTable, largePages) {
+
+	transpositionTable& tt = transpositionTable::getInstance();
+	tt.setSize(4);
+	tt.setLargePages(true);
+	tt.clear();
+
+	HashKey k(0x123456789ABCDEF0ull);
+	tt.store(k, 250, typeExact, 8, Move(0x1234), 100);
+	ttEntry tte = tt.probe(k);
+	EXPECT_EQ(tte.getValue(), 250);
+	EXPECT_EQ(tte.getPackedMove(), 0x1234);
+
+	// changing the backing reallocates an empty table
+	tt.setLargePages(false);
+	EXPECT_EQ(tt.getMemoryType(), transpositionTable::memoryType::normalPages);
+	tte = tt.probe(k);
+	EXPECT_EQ(tte.getType(), typeVoid);
+
+	tt.setSize(1);
+}
+
+TEST(transpositionTable, saveAndLoad) {
+
+	transpositionTable& tt = transpositionTable::getInstance();
+	tt.setSize(1);
+	tt.clear();
+
+	HashKey k(0x123456789ABCDEF0ull);
+	tt.store(k, -1234, typeScoreHigherThanBeta, 20, Move(0x4321), 567);
+	ASSERT_TRUE(tt.saveToFile("tt-test.bin"));
+
+	tt.clear();
+	EXPECT_EQ(tt.probe(k).getType(), typeVoid);
+
+	ASSERT_TRUE(tt.loadFromFile("tt-test.bin"));
+	EXPECT_EQ(tt.getElements(), 65536u);
+	ttEntry tte = tt.probe(k);
+	EXPECT_EQ(tte.getValue(), -1234);
+	EXPECT_EQ(tte.getStaticValue(), 567);
+	EXPECT_EQ(tte.getDepth(), 20);
+	EXPECT_EQ(tte.getPackedMove(), 0x4321);
+	EXPECT_EQ(tte.getType(), typeScoreHigherThanBeta);
+
+	// the loaded table is writable
+	tt.store(HashKey(0x2222222211111111ull), 10, typeExact, 4, Move(0x1111), 20);
+	EXPECT_EQ(tt.probe(HashKey(0x2222222211111111ull)).getValue(), 10);
+
+	// a number of clusters whose size overflows is rejected, the header stores it after magic, version and cluster size
+	{
+		std::fstream f("tt-test.bin", std::ios::binary | std::ios::in | std::ios::out);
+		const uint64_t elements = 1ull << 58;
+		f.seekp(16);
+		f.write(reinterpret_cast<const char*>(&elements), sizeof(elements));
+	}
+	EXPECT_FALSE(tt.loadFromFile("tt-test.bin"));
+
+	std::remove("tt-test.bin");
+	EXPECT_FALSE(tt.loadFromFile("tt-test.bin"));
+
+	tt.setSize(1);
+}
+
+TEST(transpositionTable, statistics) {
+
+	searchStatistics::threadScope scope;
+	transpositionTable& tt = transpositionTable::getInstance();
+	tt.setSize(1);
+	tt.clear();
+	searchStatistics::reset();
+
+	HashKey k(0x123456789ABCDEF0ull);
+	tt.probe(k);
+	tt.store(k, 100, typeExact, 8, Move(0x1234), 50);
+	tt.store(k, 100, typeScoreHigherThanBeta, 9, Move(0x1234), 50);
+	tt.probe(k);
+
+	// counters of other threads are aggregated, also after the thread is terminated
+	std::thread t([&]() { searchStatistics::threadScope s; tt.probe(k); });
+	t.join();
+
+	auto v = searchStatistics::get();
+	EXPECT_EQ(v[searchStatistics::probes], 3u);
+	EXPECT_EQ(v[searchStatistics::hitLowerBound], 2u);
+	EXPECT_EQ(v[searchStatistics::hitExact], 0u);
+	EXPECT_EQ(v[searchStatistics::storeEmpty], 1u);
+	EXPECT_EQ(v[searchStatistics::storeSameKey], 1u);
+	EXPECT_EQ(v[searchStatistics::storeReplace], 0u);
+
+	searchStatistics::reset();
+	v = searchStatistics::get();
+	EXPECT_EQ(v[searchStatistics::probes], 0u);
+
+	tt.clear();
+}